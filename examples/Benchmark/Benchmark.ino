@@ -0,0 +1,102 @@
+/**
+ * @file Benchmark.ino
+ *
+ * This example measures how many CPU cycles the audio front end costs per
+ * window. It alternates between two paths on live input windows:
+ *
+ * - legacy: the original chain of separate passes (DC removal, windowing,
+ *   a full WINDOW_SIZE complex FFT and a double precision magnitude pass)
+ *   run on a local buffer filled by AudioLab.
+ * - fused: VibrosonicsAPI::processAudioInput, which removes DC, windows and
+ *   packs the samples in one pass, runs a half-size real-input FFT and
+ *   writes magnitudes straight into the output.
+ *
+ * The mean cycles per window of each path are printed every REPORT_WINDOWS
+ * windows, along with the window deadline in cycles for reference. The RAM
+ * the API holds is printed once at startup.
+ */
+
+#include "VibrosonicsAPI.h"
+
+#define REPORT_WINDOWS 100
+
+VibrosonicsAPI vapi = VibrosonicsAPI();
+
+float windowData[WINDOW_SIZE_BY_2];
+
+// buffers for the legacy path
+complex legacyData[WINDOW_SIZE];
+float legacyHamming[WINDOW_SIZE];
+
+uint64_t legacyCycles = 0;
+uint64_t fusedCycles = 0;
+int legacyWindows = 0;
+int fusedWindows = 0;
+bool runLegacy = true;
+
+void setup() {
+  Serial.begin(115200);
+
+  vapi.init();
+  vapi.printMemoryFootprint();
+
+  float step = 2 * PI / (WINDOW_SIZE - 1);
+  for (int i = 0; i < WINDOW_SIZE; i++) {
+    legacyHamming[i] = 0.54 - 0.46 * cos(step * i);
+  }
+}
+
+void loop() {
+  if (runLegacy) {
+    if (!AudioLab.ready<complex>(legacyData)) {
+      return;
+    }
+
+    uint32_t start = ESP.getCycleCount();
+    runLegacyFrontEnd();
+    legacyCycles += ESP.getCycleCount() - start;
+    legacyWindows++;
+  } else {
+    if (!vapi.isAudioLabReady()) {
+      return;
+    }
+
+    uint32_t start = ESP.getCycleCount();
+    vapi.processAudioInput(windowData);
+    fusedCycles += ESP.getCycleCount() - start;
+    fusedWindows++;
+  }
+  runLegacy = !runLegacy;
+
+  if (fusedWindows == REPORT_WINDOWS) {
+    uint32_t deadline = (uint64_t)ESP.getCpuFreqMHz() * 1000000 * WINDOW_SIZE / SAMPLE_RATE;
+    Serial.printf("WINDOW_SIZE %d, deadline %u cycles/window\n", WINDOW_SIZE, deadline);
+    Serial.printf("- legacy: %llu cycles/window\n", legacyCycles / legacyWindows);
+    Serial.printf("- fused:  %llu cycles/window\n", fusedCycles / fusedWindows);
+
+    legacyCycles = fusedCycles = 0;
+    legacyWindows = fusedWindows = 0;
+  }
+}
+
+// The front end as it was before it was fused, kept here as the baseline.
+void runLegacyFrontEnd() {
+  float mean = 0.0;
+  for (int i = 0; i < WINDOW_SIZE; i++) {
+    mean += legacyData[i].re();
+  }
+  mean /= WINDOW_SIZE;
+  for (int i = 0; i < WINDOW_SIZE; i++) {
+    legacyData[i] -= mean;
+  }
+  for (int i = 0; i < WINDOW_SIZE; i++) {
+    legacyData[i] *= legacyHamming[i];
+  }
+  Fast4::FFT(legacyData, WINDOW_SIZE);
+  for (int i = 0; i < WINDOW_SIZE; i++) {
+    legacyData[i] = sqrt(pow(legacyData[i].re(), 2) + pow(legacyData[i].im(), 2));
+  }
+  for (int i = 0; i < WINDOW_SIZE_BY_2; i++) {
+    windowData[i] = legacyData[i].re();
+  }
+}
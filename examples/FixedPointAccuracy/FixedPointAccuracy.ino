@@ -0,0 +1,111 @@
+/**
+ * @file FixedPointAccuracy.ino
+ *
+ * This example reports how closely the Q15 and Q31 fixed-point pipelines
+ * follow the float front end, so precision can be traded for cycles
+ * knowingly. Every REPORT_WINDOWS windows it prints, for the same ADC
+ * samples, each bin's float magnitude next to the Q15 and Q31 magnitudes
+ * (converted to float units), followed by the maximum absolute error, the
+ * signal to error ratio and the cycles each path took.
+ *
+ * The library itself selects the fixed-point chain at compile time by
+ * defining VIBROSONICS_FIXED_POINT as q15_t or q31_t in the build flags; this
+ * example uses the pipelines directly so it can compare all three at once.
+ */
+
+#include "VibrosonicsAPI.h"
+
+#define REPORT_WINDOWS 50
+
+int samples[WINDOW_SIZE];
+
+// float reference
+complex floatData[WINDOW_SIZE];
+float hamming[WINDOW_SIZE];
+float floatOutput[WINDOW_SIZE_BY_2];
+
+FixedPointPipeline<q15_t> q15Pipeline;
+FixedPointPipeline<q31_t> q31Pipeline;
+q15_t q15Output[WINDOW_SIZE_BY_2];
+q31_t q31Output[WINDOW_SIZE_BY_2];
+
+int windowCount = 0;
+
+void setup() {
+  Serial.begin(115200);
+
+  AudioLab.init();
+  q15Pipeline.init();
+  q31Pipeline.init();
+
+  float step = 2 * PI / (WINDOW_SIZE - 1);
+  for (int i = 0; i < WINDOW_SIZE; i++) {
+    hamming[i] = 0.54 - 0.46 * cos(step * i);
+  }
+}
+
+void loop() {
+  if (!AudioLab.ready<int>(samples)) {
+    return;
+  }
+
+  uint32_t start = ESP.getCycleCount();
+  processFloat();
+  uint32_t floatCycles = ESP.getCycleCount() - start;
+
+  start = ESP.getCycleCount();
+  q15Pipeline.processSamples(samples, q15Output);
+  uint32_t q15Cycles = ESP.getCycleCount() - start;
+
+  start = ESP.getCycleCount();
+  q31Pipeline.processSamples(samples, q31Output);
+  uint32_t q31Cycles = ESP.getCycleCount() - start;
+
+  if (++windowCount < REPORT_WINDOWS) {
+    return;
+  }
+  windowCount = 0;
+
+  Serial.printf("bin,freq,float,q15,q31\n");
+  float q15MaxError = 0.0, q31MaxError = 0.0;
+  float signal = 0.0, q15Error = 0.0, q31Error = 0.0;
+  for (int i = 0; i < WINDOW_SIZE_BY_2; i++) {
+    float q15 = q15Pipeline.toFloat(q15Output[i]);
+    float q31 = q31Pipeline.toFloat(q31Output[i]);
+    Serial.printf("%d,%g,%g,%g,%g\n", i, i * FREQ_RES, floatOutput[i], q15, q31);
+
+    float q15Diff = q15 - floatOutput[i];
+    float q31Diff = q31 - floatOutput[i];
+    q15MaxError = max(q15MaxError, fabsf(q15Diff));
+    q31MaxError = max(q31MaxError, fabsf(q31Diff));
+    signal += floatOutput[i] * floatOutput[i];
+    q15Error += q15Diff * q15Diff;
+    q31Error += q31Diff * q31Diff;
+  }
+
+  Serial.printf("float: %u cycles\n", floatCycles);
+  Serial.printf("q15: %u cycles, max error %g, SER %.1f dB, step %g\n", q15Cycles,
+                q15MaxError, 10 * log10f(signal / max(q15Error, 1e-12f)),
+                q15Pipeline.magnitudeScale());
+  Serial.printf("q31: %u cycles, max error %g, SER %.1f dB, step %g\n", q31Cycles,
+                q31MaxError, 10 * log10f(signal / max(q31Error, 1e-12f)),
+                q31Pipeline.magnitudeScale());
+}
+
+// The float front end, run on the same samples as the fixed-point pipelines.
+void processFloat() {
+  float mean = 0.0;
+  for (int i = 0; i < WINDOW_SIZE; i++) {
+    mean += samples[i];
+  }
+  mean /= WINDOW_SIZE;
+  for (int i = 0; i < WINDOW_SIZE; i++) {
+    floatData[i] = complex((samples[i] - mean) * hamming[i], 0.0);
+  }
+  Fast4::FFT(floatData, WINDOW_SIZE);
+  for (int i = 0; i < WINDOW_SIZE_BY_2; i++) {
+    float re = floatData[i].re();
+    float im = floatData[i].im();
+    floatOutput[i] = sqrtf(re * re + im * im);
+  }
+}
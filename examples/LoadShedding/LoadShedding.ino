@@ -0,0 +1,113 @@
+/**
+ * @file LoadShedding.ino
+ *
+ * This example shows how to keep haptic latency stable when the analysis is
+ * too heavy for the window deadline (WINDOW_SIZE / SAMPLE_RATE). The API times
+ * every window from isAudioLabReady to the next poll and derives a load level
+ * from it; the degradation policy set in setup decides what gives way as the
+ * load rises:
+ *
+ * - at LOAD_HIGH, the optional percussion analysis is skipped and CFAR uses
+ *   fewer reference cells.
+ * - at LOAD_CRITICAL, CFAR is narrowed further and at most a few grains may
+ *   run at once.
+ *
+ * Every REPORT_WINDOWS windows the overrun and dropped window counts are
+ * printed along with the current load.
+ */
+
+#include "VibrosonicsAPI.h"
+
+#define NUM_PEAKS 4
+#define REPORT_WINDOWS 200
+
+#define PERC_FREQ_LO 1800
+#define PERC_FREQ_HI 4000
+
+VibrosonicsAPI vapi = VibrosonicsAPI();
+
+// buffers of the current window only, taken from vapi's scratch arena
+float* windowData = nullptr;
+float* filteredData = nullptr;
+
+// core analysis: the loudest peaks, always run
+Spectrogram peakSpectrogram = Spectrogram(2);
+ModuleGroup peakModules = ModuleGroup(&peakSpectrogram);
+MajorPeaks majorPeaks = MajorPeaks(NUM_PEAKS);
+
+// optional analysis: percussion, skipped under load
+Spectrogram percussiveSpectrogram = Spectrogram(2);
+ModuleGroup percussiveModules = ModuleGroup(&percussiveSpectrogram);
+PercussionDetection percussionDetection = PercussionDetection(0.5, 1800000, 0.75);
+
+int windowsSinceReport = 0;
+
+void setup() {
+  Serial.begin(115200);
+  vapi.init();
+
+  peakModules.addModule(&majorPeaks, 20, 3000);
+  percussiveModules.addModule(&percussionDetection, PERC_FREQ_LO, PERC_FREQ_HI);
+
+  DegradationPolicy policy;
+  policy.highLoad = 0.7;
+  policy.criticalLoad = 0.95;
+  policy.skipOptional[LOAD_HIGH] = true;
+  policy.skipOptional[LOAD_CRITICAL] = true;
+  policy.maxCFARRefs[LOAD_HIGH] = 8;
+  policy.maxCFARRefs[LOAD_CRITICAL] = 4;
+  policy.maxGrains[LOAD_CRITICAL] = 4;
+  vapi.setDegradationPolicy(policy);
+}
+
+void loop() {
+  if (!vapi.isAudioLabReady()) {
+    return;
+  }
+
+  ScratchArena* scratch = vapi.getScratchArena();
+  windowData = scratch->allocate<float>(WINDOW_SIZE_BY_2);
+  filteredData = scratch->allocate<float>(WINDOW_SIZE_BY_2);
+  // the arena reports when it is too small for the buffers
+  if (!windowData || !filteredData) {
+    return;
+  }
+
+  vapi.processAudioInput(windowData);
+  vapi.noiseFloor(windowData, 300);
+
+  // a wide order statistic CFAR is robust but costly, the policy narrows it
+  // under load
+  vapi.noiseFloorCFAR(windowData, filteredData, 16, 2, 1.4, OS_CFAR);
+
+  peakSpectrogram.pushWindow(filteredData);
+  peakModules.runAnalysis();
+
+  float** peaksData = majorPeaks.getOutput();
+  vapi.mapAmplitudes(peaksData[MP_AMP], NUM_PEAKS, 10000);
+  for (int i = 0; i < NUM_PEAKS; i++) {
+    float freq = vapi.mapFrequencyMIDI(peaksData[MP_FREQ][i], 20, 3000);
+    vapi.assignWave(freq, peaksData[MP_AMP][i], 0);
+  }
+
+  if (vapi.shouldRunOptionalStages()) {
+    percussiveSpectrogram.pushWindow(windowData);
+    percussiveModules.runAnalysis();
+    if (percussionDetection.getOutput()) {
+      FreqEnv freqEnv = vapi.createFreqEnv(160, 160, 160, 20);
+      AmpEnv ampEnv = vapi.createAmpEnv(1.0, 1.0, 0.3, 0.0);
+      DurEnv durEnv = vapi.createDurEnv(1, 0, 1, 3, 1.0);
+      // returns nullptr when the policy caps the number of grains
+      vapi.createDynamicGrain(1, TRIANGLE, freqEnv, ampEnv, durEnv);
+    }
+  }
+
+  vapi.updateGrains();
+  AudioLab.synthesize();
+
+  if (++windowsSinceReport == REPORT_WINDOWS) {
+    vapi.getDeadlineMonitor()->printStatus();
+    Serial.printf("scratch high-water mark: %u bytes\n", (unsigned)scratch->getHighWaterMark());
+    windowsSinceReport = 0;
+  }
+}
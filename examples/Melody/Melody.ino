@@ -9,16 +9,24 @@
 
 VibrosonicsAPI vapi = VibrosonicsAPI();
 
-float windowData[WINDOW_SIZE_BY_2] = { 0 };
-float filteredData[WINDOW_SIZE_BY_2] = { 0 };
+// the newest spectrum, owned by vapi's spectrum history
+float *windowData = nullptr;
+
+// the smoothed data follows the spectrum from window to window
 float smoothedData[WINDOW_SIZE_BY_2] = { 0 };
-float melodicData[WINDOW_SIZE_BY_2] = { 0 };
+
+// buffers of the current window only, taken from vapi's scratch arena
+float *filteredData = nullptr;
+float *melodicData = nullptr;
 
 Spectrogram melodicSpectrogram = Spectrogram(2);
 ModuleGroup melodic = ModuleGroup(&melodicSpectrogram);
 MajorPeaks midPeak = MajorPeaks(1);
 MajorPeaks highPeak = MajorPeaks(1);
 
+// declared ahead of use so the sketch also builds as plain C++ on the host
+void synthesizePeak(int channel, float freq, float amp, float freqMax);
+
 void setup() {
   Serial.begin(115200);
 
@@ -41,32 +49,32 @@ void loop() {
   }
 
   // process the raw audio signal into frequency domain data
-  vapi.processAudioInput(windowData);
+  windowData = vapi.processAudioInput();
+  ScratchArena *scratch = vapi.getScratchArena();
+  filteredData = scratch->allocate<float>(WINDOW_SIZE_BY_2);
+  melodicData = scratch->allocate<float>(WINDOW_SIZE_BY_2);
+  // the arena reports when it is too small for the buffers
+  if (!filteredData || !melodicData) {
+    return;
+  }
 
   // process the freqeuncy domain data
 
   // floor the noise from the wire using a set threshold
   vapi.noiseFloor(windowData, NOISE_FLOOR);
 
-  // copy the windowData to filterdData
-  memcpy(filteredData, windowData, WINDOW_SIZE_BY_2 * sizeof(float));
-
-  // apply CFAR to filter the data
-  vapi.noiseFloorCFAR(filteredData, 6, 1, 1.4);
+  // apply CFAR to filter the windowData into filteredData
+  vapi.noiseFloorCFAR(windowData, filteredData, 6, 1, 1.4);
 
   // smooth the filtered data over a long and short period of time
   AudioPrism::smooth_window_over_time(filteredData, smoothedData, 0.3);
 
-  // calculate the percussive and melodic data
-  for (int i = 0; i < WINDOW_SIZE_BY_2; i++) {
-    // the smoothedData value is usually less than windowData's, but in the
-    // case that windowData dropped quickly (becomes less than the
-    // smoothedData) we want to adapt to that
-    melodicData[i] = min(windowData[i], smoothedData[i]);
-    if (melodicData[i] < NOISE_FLOOR) {
-      melodicData[i] = 0.;
-    }
-  }
+  // calculate the melodic data
+  // the smoothedData value is usually less than windowData's, but in the
+  // case that windowData dropped quickly (becomes less than the
+  // smoothedData) we want to adapt to that
+  Kernels::minimum(windowData, smoothedData, melodicData, WINDOW_SIZE_BY_2);
+  Kernels::threshold(melodicData, NOISE_FLOOR, melodicData, WINDOW_SIZE_BY_2);
 
   // push the short smoothed data for the melodic peak detection
   melodicSpectrogram.pushWindow(melodicData);
@@ -94,22 +102,10 @@ void loop() {
   // AudioLab.printWaves();
 }
 
-int interpolateAroundPeak(float *data, int indexOfPeak) {
-  float prePeak = indexOfPeak == 0 ? 0.0 : data[indexOfPeak - 1];
-  float atPeak = data[indexOfPeak];
-  float postPeak = indexOfPeak == WINDOW_SIZE_BY_2 ? 0.0 : data[indexOfPeak + 1];
-  // summing around the index of maximum amplitude to normalize magnitudeOfChange
-  float peakSum = prePeak + atPeak + postPeak;
-  // interpolating the direction and magnitude of change, and normalizing from -1.0 to 1.0
-  float magnitudeOfChange = ((atPeak + postPeak) - (atPeak + prePeak)) / (peakSum > 0.0 ? peakSum : 1.0);
-
-  // return interpolated frequency
-  return int(round((float(indexOfPeak) + magnitudeOfChange) * FREQ_RES));
-}
-
 void synthesizePeak(int channel, float freq, float amp, float freqMax) {
-  // interpolate the frequency around the peak to get a more accurate measure
-  float interp_freq = interpolateAroundPeak(windowData, int(round(freq * FREQ_WIDTH)));
+  // refine the frequency to between bins to get a more accurate measure
+  float interp_freq;
+  vapi.refinePeaks(windowData, &freq, &interp_freq, nullptr, 1, PEAK_GAUSSIAN);
 
   // map the frequency to the haptic range by dividing it by 2 (transposing by
   // octaves) until it is below 230Hz. This is why 3600Hz is a better max
@@ -154,7 +154,7 @@ void loop() {
      * -- Retrieve MajorPeaks data
     */
     float **bass_data = bass_peaks.getOutput();
-    vapi.mapAmplitudes(bass_data[MP_AMP], NUM_BASS_PEAKS, 250);
+    vapi.mapAmplitudes(bass_data[MP_AMP], NUM_BASS_PEAKS, 250, 0.05, 0);
     // -- Trigger grains with frequencies and grains
     vapi.triggerGrains(NUM_BASS_PEAKS, bass_data, bass_grains);
 
@@ -179,7 +179,7 @@ void loop() {
 
         // Retrieve the MajorPeaks data for the mid range
         float **mid_data = mid_peaks.getOutput();
-        vapi.mapAmplitudes(mid_data[MP_AMP], NUM_MID_PEAKS, 550);
+        vapi.mapAmplitudes(mid_data[MP_AMP], NUM_MID_PEAKS, 550, 0.05, 1);
 
         // Transpose detected notes down by octaves until they're below 200 Hz.
         // This places all notes in the range of 100 - 200 Hz
@@ -229,7 +229,7 @@ void loop() {
         // for the volume of the percussion that triggered the snare_detector.
         // -- Measure the mean amplitude between 2000-4000 Hz
         float mean = meanAmp.getOutput();
-        vapi.mapAmplitudes(&mean, 1, 75);
+        vapi.mapAmplitudes(&mean, 1, 75, 0.05, 2);
         // -- Adjust the dynamic range of snare triggerings
         float snare_amp = pow(mean, 3.0);
         float boost = 8.0;
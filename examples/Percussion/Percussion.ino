@@ -7,6 +7,10 @@
  * audio signal. This filtered data is used as the input to an AudioPrism
  * PercussionDetection module, which tells us when to output grains
  * corresponding to snare/hi-hat haptic feedback.
+ *
+ * Lowering HOP_SIZE to WINDOW_SIZE_BY_2 or WINDOW_SIZE_BY_4 runs detection on
+ * 50% or 75% overlapping windows, placing hits on a finer time grid without
+ * shrinking the window. The thresholds were tuned without overlap.
  */
 
 #define PERC_FREQ_LO 1800
@@ -21,12 +25,21 @@
 
 #include "VibrosonicsAPI.h"
 
+// samples between the windows percussion is detected in
+#define HOP_SIZE WINDOW_SIZE
+
 VibrosonicsAPI vapi = VibrosonicsAPI();
 
-float windowData[WINDOW_SIZE_BY_2];
-float filteredData[WINDOW_SIZE_BY_2] = { 0 };
+// the newest spectrum, owned by vapi's spectrum history
+float* windowData = nullptr;
+
+// the smoothed data follows the spectrum from window to window
 float smoothedData[WINDOW_SIZE_BY_2] = { 0 };
 
+// the CFAR output of each hop, taken from vapi's scratch arena every window
+// and reused by its hops
+float* filteredData = nullptr;
+
 // Create the spectrogram which will store our filtered percussive data. It
 // needs at least two windows to be able to calculate the energy flux between
 // windows.
@@ -45,9 +58,14 @@ FreqEnv freqEnv = {};
 AmpEnv ampEnv = {};
 DurEnv durEnv = {};
 
+// declared ahead of use so the sketch also builds as plain C++ on the host
+void detectPercussion();
+void synthesizeHit(float flux);
+
 void setup() {
   Serial.begin(115200);
   vapi.init();
+  vapi.setHopSize(HOP_SIZE);
 
   durEnv = vapi.createDurEnv(1, 0, 1, 3, 1.0);
   // Optional: set the debug mode on the PercussionDetection module:
@@ -61,18 +79,39 @@ void loop() {
   if (!vapi.isAudioLabReady()) {
     return;
   }
+  filteredData = vapi.getScratchArena()->allocate<float>(WINDOW_SIZE_BY_2);
+  if (!filteredData) {
+    return;
+  }
+
+  // Look for hits in every hop of the recorded window, just one without
+  // overlap.
+  while (vapi.getPendingHops() > 0) {
+    detectPercussion();
+  }
+
+  // Update the percussive grains created.
+  vapi.updateGrains();
+
+  // Map the amplitudes of both channels for output through the DAC.
+  AudioLab.mapAmplitudes(0, AMPLITUDE_MAPPING );
+  AudioLab.mapAmplitudes(1, AMPLITUDE_MAPPING);
 
+  // Synthesize the waves created for haptic feedback.
+  AudioLab.synthesize();
+}
+
+// Runs percussion detection on the next hop and creates grains for a hit.
+void detectPercussion() {
   // Collect the audio signal data of the recorded window.
-  vapi.processAudioInput(windowData);
+  windowData = vapi.processAudioInput();
 
   // Floor noise from the wire.
   vapi.noiseFloor(windowData, 300);
 
-  // Create a copy of the raw window data for further noise filtering.
-  memcpy(filteredData, windowData, WINDOW_SIZE_BY_2 * sizeof(float));
-
-  // Apply CFAR to clean up the data.
-  vapi.noiseFloorCFAR(filteredData, 6, 1, 1.4);
+  // Apply CFAR to clean up a copy of the raw window data, keeping the raw
+  // data for further noise filtering.
+  vapi.noiseFloorCFAR(windowData, filteredData, 6, 1, 1.4);
 
   // Smooth the filterd data over a long period of time to capture melodic
   // elements (frequencies present over multiple windows).
@@ -80,9 +119,8 @@ void loop() {
 
   // Subtract the melodic data from the raw data to capture the 'percussive
   // data'.
-  for (int i = 0; i < WINDOW_SIZE_BY_2; i++) {
-    windowData[i] = max((float)0., windowData[i] - smoothedData[i]);
-  }
+  Kernels::subtract(windowData, smoothedData, windowData, WINDOW_SIZE_BY_2);
+  Kernels::threshold(windowData, 0.0, windowData, WINDOW_SIZE_BY_2);
 
   // Finally, the window data has been filtered for percussion, so push this
   // into the spectrogram that the PercussionDetection module will use as
@@ -133,16 +171,6 @@ void loop() {
     // For debugging purposes, to complement the previous print statements.
     Serial.printf("---\n\n");
   }
-
-  // Update the percussive grains created.
-  vapi.updateGrains();
-
-  // Map the amplitudes of both channels for output through the DAC.
-  AudioLab.mapAmplitudes(0, AMPLITUDE_MAPPING );
-  AudioLab.mapAmplitudes(1, AMPLITUDE_MAPPING);
-
-  // Synthesize the waves created for haptic feedback.
-  AudioLab.synthesize();
 }
 
 // Synthesize the percussive hit to either one or both speakers, based on the
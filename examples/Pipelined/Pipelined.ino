@@ -0,0 +1,75 @@
+/**
+ * @file Pipelined.ino
+ *
+ * This example runs the front end and the analysis on different cores of the
+ * ESP32. Once startPipeline is called, a task on PIPELINE_CORE captures each
+ * window and computes its spectrum while loop(), on the other core, analyzes
+ * and synthesizes the previous one, so the analysis gets close to a whole
+ * window of time to itself.
+ *
+ * In pipelined mode the sketch takes spectra with acquireSpectrum instead of
+ * isAudioLabReady and processAudioInput. The spectrum can be changed in place
+ * and must be handed back with releaseSpectrum once the sketch is done with
+ * it; after that it can still be read through vapi.getSpectrum(0) until
+ * SPECTRUM_HISTORY newer spectra have been released.
+ */
+
+#include "VibrosonicsAPI.h"
+
+#define NUM_PEAKS 4
+#define REPORT_WINDOWS 200
+
+VibrosonicsAPI vapi = VibrosonicsAPI();
+
+// the CFAR output of the current window, taken from vapi's scratch arena
+float* filteredData = nullptr;
+
+Spectrogram processedSpectrogram = Spectrogram(2);
+ModuleGroup modules = ModuleGroup(&processedSpectrogram);
+MajorPeaks majorPeaks = MajorPeaks(NUM_PEAKS);
+
+int windowsSinceReport = 0;
+
+void setup() {
+  Serial.begin(115200);
+  vapi.init();
+  modules.addModule(&majorPeaks, 20, 3000);
+
+  if (!vapi.startPipeline()) {
+    Serial.printf("Could not start the pipeline\n");
+  }
+}
+
+void loop() {
+  float* windowData = vapi.acquireSpectrum();
+  if (!windowData) {
+    return;
+  }
+
+  filteredData = vapi.getScratchArena()->allocate<float>(WINDOW_SIZE_BY_2);
+  if (!filteredData) {
+    vapi.releaseSpectrum();
+    return;
+  }
+  vapi.noiseFloor(windowData, 300);
+  vapi.noiseFloorCFAR(windowData, filteredData, 4, 1, 1.6);
+
+  // the spectrum is no longer needed, let the front end reuse its frame
+  vapi.releaseSpectrum();
+
+  processedSpectrogram.pushWindow(filteredData);
+  modules.runAnalysis();
+
+  float** peaksData = majorPeaks.getOutput();
+  vapi.mapAmplitudes(peaksData[MP_AMP], NUM_PEAKS, 10000);
+  vapi.assignWaves(peaksData[MP_FREQ], peaksData[MP_AMP], NUM_PEAKS, 0);
+  vapi.assignWaves(peaksData[MP_FREQ], peaksData[MP_AMP], NUM_PEAKS, 1);
+
+  AudioLab.synthesize();
+
+  if (++windowsSinceReport == REPORT_WINDOWS) {
+    Serial.printf("dropped by the front end: %u\n", vapi.getPipelineDrops());
+    vapi.getDeadlineMonitor()->printStatus();
+    windowsSinceReport = 0;
+  }
+}
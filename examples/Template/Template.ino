@@ -21,9 +21,10 @@
 VibrosonicsAPI vapi = VibrosonicsAPI();
 
 // DATA
-// Array that stores the AudioLab input buffer time domain data
-// After FFT processing it becomes the current window's spectrogram data
-float windowData[WINDOW_SIZE_BY_2];
+// Points to the current window's frequency domain data. The array itself is
+// owned by the API, which keeps the last SPECTRUM_HISTORY windows around (see
+// vapi.getSpectrum), so it is never copied.
+float* windowData = nullptr;
 
 // Stores 2 windows of processed data
 // Most of the time you will be using processed data for analysis
@@ -71,9 +72,9 @@ void loop()
 
   // Second, the input must be processed for analysis
   // Vibrosonics API performs these steps:
-  // Copies samples from the AudioLab buffer to the vReal array
-  // Perfroms FFT operations on vReal
-  vapi.processAudioInput(windowData);
+  // Removes the DC offset and windows the AudioLab input samples
+  // Performs FFT operations and writes the magnitudes to a new spectrum
+  windowData = vapi.processAudioInput();
 
   // Basic noise flooring (zeroing below a threshold) is used to clear out the
   // known signal noise. You can adjust this threshold by looking at the
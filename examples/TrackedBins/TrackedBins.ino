@@ -0,0 +1,60 @@
+/**
+ * @file TrackedBins.ino
+ *
+ * This example follows the strongest tone in a single band without running
+ * an FFT. The bins of the band are added to a sliding DFT that is handed to
+ * the API, which isAudioLabReady updates with every incoming sample, so each
+ * window only costs a few multiplies per sample and bin. The loudest tracked bin is
+ * transposed into the haptic range and output on the left channel.
+ *
+ * A band of a dozen bins is a good fit; beyond a few dozen bins the full
+ * FFT of processAudioInput becomes the cheaper option.
+ */
+
+#include "VibrosonicsAPI.h"
+
+#define BAND_FREQ_LO 500
+#define BAND_FREQ_HI 900
+#define NOISE_FLOOR 280
+
+VibrosonicsAPI vapi = VibrosonicsAPI();
+
+SlidingDFT bins;
+float magnitudes[SLIDING_DFT_BINS];
+
+void setup() {
+  Serial.begin(115200);
+  vapi.init();
+
+  // track every bin of the band
+  for (float freq = BAND_FREQ_LO; freq <= BAND_FREQ_HI; freq += FREQ_RES) {
+    bins.addFrequency(freq);
+  }
+  vapi.setSlidingDFT(&bins);
+  Serial.printf("tracking %d bins\n", bins.getNumBins());
+}
+
+void loop() {
+  // the tracked bins are brought up to date while the window is captured
+  if (!vapi.isAudioLabReady()) {
+    return;
+  }
+
+  bins.getMagnitudes(magnitudes);
+
+  // find the loudest bin of the band
+  int loudest = 0;
+  for (int i = 1; i < bins.getNumBins(); i++) {
+    if (magnitudes[i] > magnitudes[loudest]) {
+      loudest = i;
+    }
+  }
+
+  if (magnitudes[loudest] > NOISE_FLOOR) {
+    float freq = vapi.mapFrequencyByOctaves(bins.getFrequency(loudest), BAND_FREQ_HI);
+    vapi.assignWave(freq, magnitudes[loudest], 0);
+  }
+
+  AudioLab.mapAmplitudes(0, 10000);
+  AudioLab.synthesize();
+}
@@ -9,16 +9,22 @@
 #define PERC_FREQ_LO 1800
 #define PERC_FREQ_HI 4000
 
+// build with VIBROSONICS_PROFILE defined to time every stage of the loop, the
+// report is printed every PROFILE_WINDOWS windows
+#define PROFILE_WINDOWS 1000
+
 VibrosonicsAPI vapi = VibrosonicsAPI();
 
-float windowData[WINDOW_SIZE_BY_2] = { 0 };
-float filteredData[WINDOW_SIZE_BY_2] = { 0 };
-float moreSmoothedData[WINDOW_SIZE_BY_2] = { 0 };
-float lessSmoothedData[WINDOW_SIZE_BY_2] = { 0 };
-float percussiveData[WINDOW_SIZE_BY_2] = { 0 };
-float melodicData[WINDOW_SIZE_BY_2] = { 0 };
+// the newest spectrum, owned by vapi's spectrum history
+float *windowData = nullptr;
+
+// the CFAR output of the current window, taken from vapi's scratch arena
+float *filteredData = nullptr;
 
-Spectrogram rawSpectrogram(1);
+// splits each window into its percussive and melodic parts, which it keeps
+PercussiveMelodicSplit split;
+float *percussiveData = split.getPercussive();
+float *melodicData = split.getMelodic();
 
 Spectrogram melodicSpectrogram = Spectrogram(2);
 ModuleGroup melodic = ModuleGroup(&melodicSpectrogram);
@@ -29,11 +35,15 @@ Spectrogram percussiveSpectrogram = Spectrogram(2);
 ModuleGroup percussive = ModuleGroup(&percussiveSpectrogram);
 PercussionDetection percussionDetection = PercussionDetection(0.5, 1800000, 0.75);
 int windowsSinceHit = 0;
+int windowsSinceReport = 0;
 
 FreqEnv freqEnv = {};
 AmpEnv ampEnv = {};
 DurEnv durEnv = {};
 
+// declared ahead of use so the sketch also builds as plain C++ on the host
+void synthesizePeak(int channel, float freq, float amp, int hasPercussion);
+
 void setup() {
   Serial.begin(115200);
 
@@ -55,6 +65,13 @@ void setup() {
   percussive.addModule(&percussionDetection, PERC_FREQ_LO, PERC_FREQ_HI);
 
   durEnv = vapi.createDurEnv(1, 0, 1, 3, 1.0);
+
+  // percussive energy rises above a slow smoothing (0.2) of the spectrum,
+  // melodic energy is capped by a faster one (0.3) and floored. Try
+  // setMethod(SPLIT_MEDIAN) for median filtering separation instead, after
+  // defining SPLIT_MEDIAN_FRAMES, e.g. as 7.
+  split.setSmoothing(0.2, 0.3);
+  split.setNoiseFloor(NOISE_FLOOR);
 }
 
 void loop() {
@@ -63,39 +80,35 @@ void loop() {
     return;
   }
 
+#ifdef VIBROSONICS_PROFILE
+  if (++windowsSinceReport == PROFILE_WINDOWS) {
+    vapi.printProfile();
+    vapi.resetProfile();
+    windowsSinceReport = 0;
+  }
+#endif
+  VIBROSONICS_PROFILE_SCOPE(vapi.profiler, "window");
+
   // process the raw audio signal into frequency domain data
-  vapi.processAudioInput(windowData);
+  windowData = vapi.processAudioInput();
+  filteredData = vapi.getScratchArena()->allocate<float>(WINDOW_SIZE_BY_2);
+  if (!filteredData) {
+    return;
+  }
 
   // process the freqeuncy domain data
 
   vapi.noiseFloor(windowData, NOISE_FLOOR);
 
-  // save the raw data for synthesis
-  rawSpectrogram.pushWindow(windowData);
+  // apply CFAR to filter the windowData into filteredData
+  vapi.noiseFloorCFAR(windowData, filteredData, 6, 1, 1.4);
 
-  // copy the windowData to filterdData
-  memcpy(filteredData, windowData, WINDOW_SIZE_BY_2 * sizeof(float));
-
-  // apply CFAR to filter the data
-  vapi.noiseFloorCFAR(filteredData, 6, 1, 1.4);
-
-  // smooth the filtered data over a long and short period of time
-  AudioPrism::smooth_window_over_time(filteredData, moreSmoothedData, 0.2);
-  AudioPrism::smooth_window_over_time(filteredData, lessSmoothedData, 0.3);
-
-  // calculate the percussive and melodic data
-  for (int i = 0; i < WINDOW_SIZE_BY_2; i++) {
-    // subtract the long smoothed melodic data from the raw data to capture the
-    // 'percussive data'
-    percussiveData[i] = max((float)0., windowData[i] - moreSmoothedData[i]);
-
-    // the smoothedData value is usually less than windowData's, but in the
-    // case that windowData dropped quickly (becomes less than the
-    // smoothedData) we want to adapt to that
-    melodicData[i] = min(windowData[i], lessSmoothedData[i]);
-    if (melodicData[i] < NOISE_FLOOR) {
-      melodicData[i] = 0.;
-    }
+  // split the window into percussive and melodic data: the percussive data
+  // is what rises above the long smoothed data, the melodic data is capped by
+  // the short smoothed data so it adapts when windowData drops quickly
+  {
+    VIBROSONICS_PROFILE_SCOPE(vapi.profiler, "splitPercussiveMelodic");
+    split.process(windowData, filteredData);
   }
 
   // push the short smoothed data for the melodic peak detection
@@ -108,8 +121,11 @@ void loop() {
   percussiveSpectrogram.pushWindow(percussiveData);
 
   // have analysis modules analyze the frequency domain data
-  melodic.runAnalysis();
-  percussive.runAnalysis();
+  {
+    VIBROSONICS_PROFILE_SCOPE(vapi.profiler, "runAnalysis");
+    melodic.runAnalysis();
+    percussive.runAnalysis();
+  }
 
   int p = percussionDetection.getOutput();
 
@@ -161,27 +177,18 @@ void loop() {
   AudioLab.mapAmplitudes(1, 10000);
 
   // synthesize the waves created
-  AudioLab.synthesize();
+  {
+    VIBROSONICS_PROFILE_SCOPE(vapi.profiler, "synthesize");
+    AudioLab.synthesize();
+  }
 
   // AudioLab.printWaves();
 }
 
-int interpolateAroundPeak(float *data, int indexOfPeak) {
-  float prePeak = indexOfPeak == 0 ? 0.0 : data[indexOfPeak - 1];
-  float atPeak = data[indexOfPeak];
-  float postPeak = indexOfPeak == WINDOW_SIZE_BY_2 ? 0.0 : data[indexOfPeak + 1];
-  // summing around the index of maximum amplitude to normalize magnitudeOfChange
-  float peakSum = prePeak + atPeak + postPeak;
-  // interpolating the direction and magnitude of change, and normalizing from -1.0 to 1.0
-  float magnitudeOfChange = ((atPeak + postPeak) - (atPeak + prePeak)) / (peakSum > 0.0 ? peakSum : 1.0);
-
-  // return interpolated frequency
-  return int(round((float(indexOfPeak) + magnitudeOfChange) * FREQ_RES));
-}
-
 void synthesizePeak(int channel, float freq, float amp, int hasPercussion) {
-  // interpolate the frequency around the peak to get a more accurate measure
-  float interp_freq = interpolateAroundPeak(windowData, int(round(freq * FREQ_WIDTH)));
+  // refine the frequency to between bins to get a more accurate measure
+  float interp_freq;
+  vapi.refinePeaks(windowData, &freq, &interp_freq, nullptr, 1, PEAK_GAUSSIAN);
 
   // map the frequency to the haptic range using MIDI note quantization
   float haptic_freq = vapi.mapFrequencyMIDI(interp_freq, MID_FREQ_LO, HIGH_FREQ_HI);
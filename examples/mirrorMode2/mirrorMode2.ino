@@ -5,9 +5,13 @@
 VibrosonicsAPI vapi = VibrosonicsAPI();
 
 float windowData[WINDOW_SIZE_BY_2];
+float peakFreqs[NUM_PEAKS];
 Spectrogram spectrogram = Spectrogram(1);
 MajorPeaks majorPeaks = MajorPeaks(NUM_PEAKS);
 
+// declared ahead of use so the sketch also builds as plain C++ on the host
+void synthesizePeaks(MajorPeaks* peaks);
+
 void setup() {
   Serial.begin(115200);
 
@@ -26,11 +30,7 @@ void loop() {
   // process the raw audio signal into frequency domain data
   vapi.processAudioInput(windowData);
 
-  for (int i = 0; i < WINDOW_SIZE_BY_2; i++) {
-    if (windowData[i] < 300) {
-      windowData[i] = 0;
-    }
-  }
+  vapi.noiseFloor(windowData, 300);
 
   spectrogram.pushWindow(windowData);
 
@@ -43,31 +43,19 @@ void loop() {
   //AudioLab.printWaves();
 }
 
-int interpolateAroundPeak(float* data, int indexOfPeak, int sampleRate, int windowSize) {
-  float _freqRes = sampleRate * 1.0 / windowSize;
-  float prePeak = indexOfPeak == 0 ? 0.0 : data[indexOfPeak - 1];
-  float atPeak = data[indexOfPeak];
-  float postPeak = indexOfPeak == WINDOW_SIZE_BY_2 ? 0.0 : data[indexOfPeak + 1];
-  // summing around the index of maximum amplitude to normalize magnitudeOfChange
-  float peakSum = prePeak + atPeak + postPeak;
-  // interpolating the direction and magnitude of change, and normalizing from -1.0 to 1.0
-  float magnitudeOfChange = ((atPeak + postPeak) - (atPeak + prePeak)) / (peakSum > 0.0 ? peakSum : 1.0);
-
-  // return interpolated frequency
-  return int(round((float(indexOfPeak) + magnitudeOfChange) * _freqRes));
-}
-
 // synthesizing should generally take from raw spectrum
 void synthesizePeaks(MajorPeaks* peaks) {
   float** peaksData = peaks->getOutput();
   // interpolate around peaks
+  vapi.refinePeaks(spectrogram.getCurrentWindow(), peaksData[MP_FREQ], peakFreqs, nullptr, NUM_PEAKS, PEAK_GAUSSIAN);
   vapi.mapAmplitudes(peaksData[MP_AMP], NUM_PEAKS);
 
+  // queue both channels and create their waves in one go
   for (int i = 0; i < NUM_PEAKS; i++) {
-    int freq = interpolateAroundPeak(spectrogram.getCurrentWindow(), round(int(peaksData[MP_FREQ][i] * FREQ_WIDTH)), SAMPLE_RATE, WINDOW_SIZE);
-    vapi.assignWave(freq, peaksData[MP_AMP][i], 0);
-    vapi.assignWave(freq, peaksData[MP_AMP][i], 1);
+    vapi.queueWave(peakFreqs[i], peaksData[MP_AMP][i], 0);
+    vapi.queueWave(peakFreqs[i], peaksData[MP_AMP][i], 1);
   }
+  vapi.submitWaves();
 }
 
 
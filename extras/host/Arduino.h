@@ -0,0 +1,92 @@
+/**
+ * @file
+ * Host stand-in for the parts of the Arduino core used by Vibrosonics and its
+ * examples, so they can be compiled and run on a desktop machine.
+*/
+
+#ifndef Arduino_h
+#define Arduino_h
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdarg>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+
+using std::max;
+using std::min;
+
+#ifndef PI
+#define PI 3.1415926535897932384626433832795
+#endif
+
+/**
+ * Serial port stand-in that writes to stdout.
+ */
+class HostSerial {
+public:
+  void begin(unsigned long baud) { (void)baud; }
+
+  void printf(const char* format, ...)
+  {
+      va_list args;
+      va_start(args, format);
+      vprintf(format, args);
+      va_end(args);
+  }
+
+  void print(const char* text) { fputs(text, stdout); }
+  void print(double value) { ::printf("%.2f", value); }
+  void print(long value) { ::printf("%ld", value); }
+  void print(int value) { ::printf("%d", value); }
+
+  void println() { putchar('\n'); }
+  template <typename T>
+  void println(T value)
+  {
+      print(value);
+      putchar('\n');
+  }
+};
+
+/**
+ * ESP stand-in. Cycles are counted in nanoseconds of wall time, reported as a
+ * 1000 MHz clock, so cycle counts and the deadline computed from
+ * getCpuFreqMHz() stay consistent with each other.
+ */
+class HostESP {
+public:
+  uint32_t getCycleCount()
+  {
+      return (uint32_t)std::chrono::duration_cast<std::chrono::nanoseconds>(
+          std::chrono::steady_clock::now().time_since_epoch()).count();
+  }
+
+  uint32_t getCpuFreqMHz() { return 1000; }
+};
+
+inline HostSerial Serial;
+inline HostESP ESP;
+
+//! Milliseconds of wall time since the first call.
+inline unsigned long millis()
+{
+    static auto start = std::chrono::steady_clock::now();
+    return (unsigned long)std::chrono::duration_cast<std::chrono::milliseconds>(
+        std::chrono::steady_clock::now() - start).count();
+}
+
+//! Microseconds of wall time since the first call.
+inline unsigned long micros()
+{
+    static auto start = std::chrono::steady_clock::now();
+    return (unsigned long)std::chrono::duration_cast<std::chrono::microseconds>(
+        std::chrono::steady_clock::now() - start).count();
+}
+
+//! Offline rendering runs as fast as possible, so delays are skipped.
+inline void delay(unsigned long ms) { (void)ms; }
+
+#endif
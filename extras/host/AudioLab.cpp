@@ -0,0 +1,237 @@
+/**
+ * @file AudioLab.cpp
+ *
+ * This file contains the host stand-in for the AudioLab library.
+ */
+
+#include "AudioLab.h"
+#include "WavFile.h"
+
+AudioLab_ AudioLab;
+
+/**
+ * Creates a stand-in with no input and no output.
+ */
+AudioLab_::AudioLab_()
+{
+    inputPosition = 0;
+    inputDone     = false;
+    numPolls      = 0;
+    outputFrames  = 0;
+    numWaves      = 0;
+}
+
+void AudioLab_::init()
+{
+}
+
+/**
+ * Loads the input signal from a WAV file. Multichannel files are mixed down
+ * to mono, and files at another rate are resampled to SAMPLE_RATE: by
+ * averaging the source samples that fall into each output sample when
+ * downsampling, which also filters most of the content that would alias, and
+ * by linear interpolation when upsampling.
+ *
+ * @param path Path of the WAV file.
+ * @return true if the file was loaded.
+ */
+bool AudioLab_::loadInput(const char* path)
+{
+    std::vector<float> samples;
+    int fileRate;
+    if (!readWav(path, samples, fileRate)) {
+        return false;
+    }
+    if (fileRate == SAMPLE_RATE || samples.empty()) {
+        loadInput(samples.data(), samples.size());
+        return true;
+    }
+
+    double step = (double)fileRate / SAMPLE_RATE;
+    size_t numSamples = (size_t)(samples.size() / step);
+    std::vector<float> resampled(numSamples);
+    for (size_t i = 0; i < numSamples; i++) {
+        double position = i * step;
+        size_t first = (size_t)position;
+        if (step > 1.0) {
+            size_t last = min((size_t)((i + 1) * step), samples.size());
+            float sum = 0.0f;
+            for (size_t j = first; j < last; j++) {
+                sum += samples[j];
+            }
+            resampled[i] = last > first ? sum / (last - first) : samples[first];
+        } else {
+            size_t next = min(first + 1, samples.size() - 1);
+            float frac = (float)(position - first);
+            resampled[i] = samples[first] + (samples[next] - samples[first]) * frac;
+        }
+    }
+    loadInput(resampled.data(), resampled.size());
+    return true;
+}
+
+/**
+ * Loads the input signal from samples already at SAMPLE_RATE, and restarts
+ * the output.
+ *
+ * @param samples Mono samples in [-1, 1].
+ * @param numSamples Number of samples.
+ */
+void AudioLab_::loadInput(const float* samples, size_t numSamples)
+{
+    input.assign(samples, samples + numSamples);
+    inputPosition = 0;
+    inputDone     = false;
+    numPolls      = 0;
+
+    output.clear();
+    output.reserve((numSamples / WINDOW_SIZE) * WINDOW_SIZE * AUD_OUT_CH);
+    outputFrames = 0;
+    numWaves     = 0;
+}
+
+/**
+ * Writes the output synthesized so far as a 16 bit WAV file with AUD_OUT_CH
+ * channels at SAMPLE_RATE.
+ *
+ * @param path Path of the WAV file.
+ * @return true if the file was written.
+ */
+bool AudioLab_::writeOutput(const char* path)
+{
+    return writeWav(path, output, AUD_OUT_CH, SAMPLE_RATE);
+}
+
+const std::vector<float>& AudioLab_::getOutput()
+{
+    return output;
+}
+
+bool AudioLab_::isFinished()
+{
+    return inputDone;
+}
+
+unsigned long AudioLab_::getNumPolls()
+{
+    return numPolls;
+}
+
+/**
+ * Creates a wave that is synthesized in the next window only.
+ *
+ * @param channel Output channel of the wave.
+ * @param freq Frequency in Hz.
+ * @param amp Amplitude; after mapAmplitudes, 1 is full scale.
+ * @param phase Phase offset in radians.
+ * @param type Shape of the wave.
+ * @return The wave, or nullptr if MAX_NUM_WAVES waves already exist or the
+ * channel is out of range.
+ */
+Wave AudioLab_::dynamicWave(uint8_t channel, float freq, float amp, float phase, WaveType type)
+{
+    if (numWaves >= MAX_NUM_WAVES || channel >= AUD_OUT_CH) {
+        return nullptr;
+    }
+    waves[numWaves].set(channel, freq, amp, phase, type);
+    return &waves[numWaves++];
+}
+
+/**
+ * Scales the amplitudes of a channel's waves by their sum, or by minSum if
+ * the sum is smaller, so quiet windows stay quiet and the channel never
+ * exceeds full scale.
+ *
+ * @param channel The channel to map.
+ * @param minSum The smallest sum to divide by.
+ */
+void AudioLab_::mapAmplitudes(uint8_t channel, float minSum)
+{
+    float sum = 0.0f;
+    for (int i = 0; i < numWaves; i++) {
+        if (waves[i].getChannel() == channel) {
+            sum += fabsf(waves[i].getAmplitude());
+        }
+    }
+
+    float divisor = max(sum, minSum);
+    if (divisor <= 0.0f) {
+        return;
+    }
+    for (int i = 0; i < numWaves; i++) {
+        if (waves[i].getChannel() == channel) {
+            waves[i].setAmplitude(waves[i].getAmplitude() / divisor);
+        }
+    }
+}
+
+/**
+ * Renders WINDOW_SIZE frames of the current waves into the output and clears
+ * them. Each wave's phase is taken from the absolute output time, so a wave
+ * that is recreated with the same frequency every window stays continuous.
+ */
+void AudioLab_::synthesize()
+{
+    size_t start = output.size();
+    output.resize(start + WINDOW_SIZE * AUD_OUT_CH, 0.0f);
+    float* frames = &output[start];
+
+    for (int w = 0; w < numWaves; w++) {
+        const wave& current = waves[w];
+        double cyclesPerSample = (double)current.getFrequency() / SAMPLE_RATE;
+        double cycle = outputFrames * cyclesPerSample + current.getPhase() / (2 * PI);
+        cycle -= floor(cycle);
+        float amp = current.getAmplitude();
+        float* out = frames + current.getChannel();
+
+        for (int i = 0; i < WINDOW_SIZE; i++) {
+            float t = (float)cycle;
+            float value;
+            switch (current.getType()) {
+            case COSINE:
+                value = cosf(2 * (float)PI * t);
+                break;
+            case SQUARE:
+                value = t < 0.5f ? 1.0f : -1.0f;
+                break;
+            case TRIANGLE:
+                value = t < 0.5f ? 4.0f * t - 1.0f : 3.0f - 4.0f * t;
+                break;
+            case SAWTOOTH:
+                value = 2.0f * t - 1.0f;
+                break;
+            default:
+                value = sinf(2 * (float)PI * t);
+                break;
+            }
+            out[i * AUD_OUT_CH] += amp * value;
+
+            cycle += cyclesPerSample;
+            cycle -= floor(cycle);
+        }
+    }
+
+    outputFrames += WINDOW_SIZE;
+    numWaves = 0;
+}
+
+/**
+ * Prints the channel, frequency, amplitude, phase and type of each wave.
+ */
+void AudioLab_::printWaves()
+{
+    for (int i = 0; i < numWaves; i++) {
+        Serial.printf("ch %d: %.2f Hz, amp %.4f, phase %.2f, type %d\n", waves[i].getChannel(),
+            waves[i].getFrequency(), waves[i].getAmplitude(), waves[i].getPhase(), waves[i].getType());
+    }
+}
+
+int AudioLab_::getNumWaves()
+{
+    return numWaves;
+}
+
+const wave* AudioLab_::getWaves()
+{
+    return waves;
+}
@@ -0,0 +1,122 @@
+/**
+ * @file
+ * Host stand-in for the AudioLab library. Instead of the ADC and DACs it
+ * reads input windows from a WAV file and renders the synthesized waves into
+ * a multichannel output buffer that can be written to a WAV file.
+*/
+
+#ifndef AudioLab_h
+#define AudioLab_h
+
+#include <Arduino.h>
+
+#include <atomic>
+#include <vector>
+
+#include "Config.h"
+#include "Wave.h"
+
+/**
+ * Offline replacement for the AudioLab object.
+ *
+ * Each call to ready() hands out the next WINDOW_SIZE samples of the loaded
+ * input as 12 bit ADC readings, and each call to synthesize() renders the
+ * waves created since the previous call as WINDOW_SIZE output samples per
+ * channel, keeping every wave's phase continuous over time.
+ */
+class AudioLab_ {
+private:
+  //! Mono input samples at SAMPLE_RATE, in [-1, 1]
+  std::vector<float> input;
+  //! Index of the first input sample of the next window
+  size_t inputPosition;
+  //! Set once ready() has run out of input. Atomic, as ready() may be polled
+  //! from a pipelined front end thread.
+  std::atomic<bool> inputDone;
+  //! Number of calls to ready(), used to detect sketches that never poll it
+  std::atomic<unsigned long> numPolls;
+
+  //! Interleaved output samples, AUD_OUT_CH per frame
+  std::vector<float> output;
+  //! Number of output frames synthesized so far
+  uint64_t outputFrames;
+
+  //! Waves created since the last synthesize
+  wave waves[MAX_NUM_WAVES];
+  int numWaves;
+public:
+  //! Default constructor.
+  AudioLab_();
+
+  //! Kept for compatibility, nothing to set up on the host.
+  void init();
+
+  //! Loads the input signal from a WAV file, resampled to SAMPLE_RATE.
+  bool loadInput(const char* path);
+
+  //! Loads the input signal from mono samples in [-1, 1] at SAMPLE_RATE.
+  void loadInput(const float* samples, size_t numSamples);
+
+  //! Writes everything synthesized so far to a WAV file.
+  bool writeOutput(const char* path);
+
+  //! Returns the synthesized output, AUD_OUT_CH interleaved samples per frame.
+  const std::vector<float>& getOutput();
+
+  //! Returns true once every full window of the input has been handed out.
+  bool isFinished();
+
+  //! Returns the number of calls made to ready().
+  unsigned long getNumPolls();
+
+  //! Copies the next input window into buffer as ADC readings.
+  template <typename T>
+  bool ready(T* buffer);
+
+  //! Creates a wave that is synthesized in the next window only.
+  Wave dynamicWave(uint8_t channel, float freq, float amp, float phase = 0, WaveType type = SINE);
+
+  //! Scales the amplitudes of a channel's waves so they sum to at most 1.
+  void mapAmplitudes(uint8_t channel, float minSum);
+
+  //! Renders one window of the current waves and clears them.
+  void synthesize();
+
+  //! Prints the current waves.
+  void printWaves();
+
+  //! Returns the number of waves created since the last synthesize.
+  int getNumWaves();
+
+  //! Returns the waves created since the last synthesize.
+  const wave* getWaves();
+};
+
+/**
+ * Copies the next WINDOW_SIZE input samples into buffer, converted to 12 bit
+ * ADC readings centered on ADC_MIDPOINT like the ESP32 input.
+ *
+ * @param buffer Receives WINDOW_SIZE samples.
+ * @return false if the input does not hold another full window.
+ */
+template <typename T>
+bool AudioLab_::ready(T* buffer)
+{
+    numPolls++;
+    if (inputPosition + WINDOW_SIZE > input.size()) {
+        inputDone = true;
+        return false;
+    }
+
+    const float* window = &input[inputPosition];
+    for (int i = 0; i < WINDOW_SIZE; i++) {
+        int reading = ADC_MIDPOINT + (int)lrintf(window[i] * (ADC_MIDPOINT - 1));
+        buffer[i] = T(min(max(reading, 0), 2 * ADC_MIDPOINT - 1));
+    }
+    inputPosition += WINDOW_SIZE;
+    return true;
+}
+
+extern AudioLab_ AudioLab;
+
+#endif
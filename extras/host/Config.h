@@ -0,0 +1,35 @@
+/**
+ * @file
+ * Host stand-in for the AudioLab configuration. Every value can be overridden
+ * on the compiler command line, e.g. -DWINDOW_SIZE=512.
+*/
+
+#ifndef Config_h
+#define Config_h
+
+#ifndef WINDOW_SIZE
+//! Number of samples in each input window.
+#define WINDOW_SIZE 256
+#endif
+
+#ifndef SAMPLE_RATE
+//! Input and output sample rate in Hz.
+#define SAMPLE_RATE 8192
+#endif
+
+#ifndef AUD_OUT_CH
+//! Number of output channels.
+#define AUD_OUT_CH 2
+#endif
+
+#ifndef MAX_NUM_WAVES
+//! Maximum number of waves that can be created per window.
+#define MAX_NUM_WAVES 64
+#endif
+
+#ifndef ADC_MIDPOINT
+//! ADC reading for a silent input; samples span 0 to 2 * ADC_MIDPOINT - 1.
+#define ADC_MIDPOINT 2048
+#endif
+
+#endif
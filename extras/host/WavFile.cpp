@@ -0,0 +1,184 @@
+/**
+ * @file WavFile.cpp
+ *
+ * This file contains the WAV file helpers used by the host build.
+ */
+
+#include "WavFile.h"
+
+#include <Arduino.h>
+
+// format tags from the WAVE specification
+#define WAVE_FORMAT_PCM 0x0001
+#define WAVE_FORMAT_IEEE_FLOAT 0x0003
+#define WAVE_FORMAT_EXTENSIBLE 0xFFFE
+
+static uint32_t readLE(const uint8_t* bytes, int numBytes)
+{
+    uint32_t value = 0;
+    for (int i = numBytes - 1; i >= 0; i--) {
+        value = (value << 8) | bytes[i];
+    }
+    return value;
+}
+
+static void writeLE(FILE* file, uint32_t value, int numBytes)
+{
+    for (int i = 0; i < numBytes; i++) {
+        fputc((value >> (8 * i)) & 0xFF, file);
+    }
+}
+
+/**
+ * Decodes one sample to [-1, 1].
+ *
+ * @param bytes The little endian sample.
+ * @param bitsPerSample Size of the sample.
+ * @param isFloat Whether the sample is IEEE float rather than integer PCM.
+ * @return float
+ */
+static float decodeSample(const uint8_t* bytes, int bitsPerSample, bool isFloat)
+{
+    if (isFloat) {
+        uint32_t bits = readLE(bytes, 4);
+        float value;
+        memcpy(&value, &bits, sizeof(value));
+        return value;
+    }
+    if (bitsPerSample == 8) {
+        // 8 bit WAV data is unsigned
+        return (bytes[0] - 128) / 128.0f;
+    }
+    int shift = 32 - bitsPerSample;
+    int32_t value = (int32_t)(readLE(bytes, bitsPerSample / 8) << shift);
+    return value / 2147483648.0f;
+}
+
+/**
+ * Reads a WAV file and mixes its channels down to mono.
+ *
+ * @param path Path of the file to read.
+ * @param samples Filled with the mono samples in [-1, 1].
+ * @param sampleRate Set to the sample rate of the file.
+ * @return true if the file was read.
+ */
+bool readWav(const char* path, std::vector<float>& samples, int& sampleRate)
+{
+    FILE* file = fopen(path, "rb");
+    if (!file) {
+        Serial.printf("Error: could not open %s\n", path);
+        return false;
+    }
+
+    uint8_t header[12];
+    if (fread(header, 1, 12, file) != 12 || memcmp(header, "RIFF", 4) || memcmp(header + 8, "WAVE", 4)) {
+        Serial.printf("Error: %s is not a WAV file\n", path);
+        fclose(file);
+        return false;
+    }
+
+    int format = 0, numChannels = 0, bitsPerSample = 0;
+    sampleRate = 0;
+    uint8_t chunk[8];
+    while (fread(chunk, 1, 8, file) == 8) {
+        uint32_t size = readLE(chunk + 4, 4);
+
+        if (!memcmp(chunk, "fmt ", 4)) {
+            std::vector<uint8_t> fmt(size);
+            if (size < 16 || fread(fmt.data(), 1, size, file) != size) {
+                break;
+            }
+            format        = readLE(&fmt[0], 2);
+            numChannels   = readLE(&fmt[2], 2);
+            sampleRate    = readLE(&fmt[4], 4);
+            bitsPerSample = readLE(&fmt[14], 2);
+            if (format == WAVE_FORMAT_EXTENSIBLE && size >= 26) {
+                // the sub format GUID starts with the actual format tag
+                format = readLE(&fmt[24], 2);
+            }
+            if (size & 1) {
+                fgetc(file);
+            }
+            continue;
+        }
+
+        if (memcmp(chunk, "data", 4)) {
+            // chunks are padded to an even size
+            fseek(file, size + (size & 1), SEEK_CUR);
+            continue;
+        }
+
+        bool isFloat = format == WAVE_FORMAT_IEEE_FLOAT;
+        if (numChannels <= 0 || !(format == WAVE_FORMAT_PCM || (isFloat && bitsPerSample == 32))
+            || bitsPerSample % 8 || bitsPerSample < 8 || bitsPerSample > 32) {
+            Serial.printf("Error: unsupported WAV format in %s\n", path);
+            fclose(file);
+            return false;
+        }
+
+        int frameSize = numChannels * bitsPerSample / 8;
+        std::vector<uint8_t> data(size);
+        size = fread(data.data(), 1, size, file);
+
+        int numFrames = size / frameSize;
+        samples.resize(numFrames);
+        for (int i = 0; i < numFrames; i++) {
+            float sum = 0.0f;
+            for (int c = 0; c < numChannels; c++) {
+                sum += decodeSample(&data[i * frameSize + c * bitsPerSample / 8], bitsPerSample, isFloat);
+            }
+            samples[i] = sum / numChannels;
+        }
+        fclose(file);
+        return true;
+    }
+
+    Serial.printf("Error: %s has no audio data\n", path);
+    fclose(file);
+    return false;
+}
+
+/**
+ * Writes interleaved samples as a 16 bit PCM WAV file. Samples outside of
+ * [-1, 1] are clipped.
+ *
+ * @param path Path of the file to write.
+ * @param samples Interleaved samples, numChannels per frame.
+ * @param numChannels Number of channels.
+ * @param sampleRate Sample rate in Hz.
+ * @return true if the file was written.
+ */
+bool writeWav(const char* path, const std::vector<float>& samples, int numChannels, int sampleRate)
+{
+    FILE* file = fopen(path, "wb");
+    if (!file) {
+        Serial.printf("Error: could not create %s\n", path);
+        return false;
+    }
+
+    uint32_t dataSize = samples.size() * 2;
+    fwrite("RIFF", 1, 4, file);
+    writeLE(file, 36 + dataSize, 4);
+    fwrite("WAVEfmt ", 1, 8, file);
+    writeLE(file, 16, 4);
+    writeLE(file, WAVE_FORMAT_PCM, 2);
+    writeLE(file, numChannels, 2);
+    writeLE(file, sampleRate, 4);
+    writeLE(file, sampleRate * numChannels * 2, 4);
+    writeLE(file, numChannels * 2, 2);
+    writeLE(file, 16, 2);
+    fwrite("data", 1, 4, file);
+    writeLE(file, dataSize, 4);
+
+    for (float sample : samples) {
+        float clipped = min(max(sample, -1.0f), 1.0f);
+        writeLE(file, (uint16_t)(int16_t)lrintf(clipped * 32767.0f), 2);
+    }
+
+    bool ok = !ferror(file);
+    fclose(file);
+    if (!ok) {
+        Serial.printf("Error: could not write %s\n", path);
+    }
+    return ok;
+}
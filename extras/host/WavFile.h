@@ -0,0 +1,18 @@
+/**
+ * @file
+ * Contains the declarations of the WAV file helpers used by the host build.
+*/
+
+#ifndef WavFile_h
+#define WavFile_h
+
+#include <vector>
+
+//! Reads a PCM (8, 16, 24 or 32 bit) or 32 bit float WAV file, mixed down to
+//! mono samples in [-1, 1].
+bool readWav(const char* path, std::vector<float>& samples, int& sampleRate);
+
+//! Writes interleaved samples in [-1, 1] as a 16 bit PCM WAV file.
+bool writeWav(const char* path, const std::vector<float>& samples, int numChannels, int sampleRate);
+
+#endif
@@ -0,0 +1,57 @@
+/**
+ * @file
+ * Host stand-in for the AudioLab wave types.
+*/
+
+#ifndef Wave_h
+#define Wave_h
+
+#include <cstdint>
+
+/**
+ * @type WaveType
+ *
+ * Shape of a synthesized wave.
+*/
+enum WaveType {
+  SINE,
+  COSINE,
+  SQUARE,
+  TRIANGLE,
+  SAWTOOTH
+};
+
+/**
+ * A wave created with AudioLab.dynamicWave, synthesized for one window.
+ */
+class wave {
+private:
+  uint8_t channel;
+  float frequency;
+  float amplitude;
+  float phase;
+  WaveType type;
+public:
+  wave() : channel(0), frequency(0), amplitude(0), phase(0), type(SINE) {}
+
+  void set(uint8_t channel, float frequency, float amplitude, float phase, WaveType type)
+  {
+      this->channel   = channel;
+      this->frequency = frequency;
+      this->amplitude = amplitude;
+      this->phase     = phase;
+      this->type      = type;
+  }
+
+  uint8_t getChannel() const { return channel; }
+  float getFrequency() const { return frequency; }
+  float getAmplitude() const { return amplitude; }
+  float getPhase() const { return phase; }
+  WaveType getType() const { return type; }
+
+  void setAmplitude(float amplitude) { this->amplitude = amplitude; }
+};
+
+typedef wave* Wave;
+
+#endif
@@ -0,0 +1,207 @@
+/**
+ * @file benchmark.cpp
+ *
+ * Host benchmark: times the VibrosonicsAPI stages a sketch runs every window
+ * and prints one JSON object per measurement, so results from different
+ * builds, WINDOW_SIZE values and machines can be collected and compared.
+ *
+ * Every measurement runs its stage for the given number of iterations on
+ * fresh input, with any setup (capturing the next window, restoring the
+ * spectrum a stage floors in place, clearing the waves of the previous
+ * iteration) done outside the timed region. Stages that take only
+ * nanoseconds are timed in batches of calls and reported per call.
+ *
+ * The stages are built for the WINDOW_SIZE the program is compiled with, so
+ * sweeping window sizes means building it once per size, see README.md.
+ */
+
+#include <Arduino.h>
+#include <AudioLab.h>
+
+#include <cstdlib>
+#include <vector>
+
+#include "VibrosonicsAPI.h"
+
+#ifdef VIBROSONICS_FIXED_POINT
+#error "The benchmark times the float front end; build it without VIBROSONICS_FIXED_POINT"
+#endif
+
+//! Number of peaks handed to assignWaves, as in the Template example
+#define BENCHMARK_PEAKS 32
+
+//! Calls per timed batch for stages that take only nanoseconds
+#define BENCHMARK_BATCH 64
+
+/**
+ * Per-call statistics of one measurement, in nanoseconds.
+ */
+struct Timing {
+  double mean;
+  double min;
+  double max;
+};
+
+typedef std::chrono::steady_clock Clock;
+
+//! Keeps the compiler from dropping calls whose results are unused.
+static volatile float sink;
+
+/**
+ * Runs setup and then body iterations times, timing only body, which makes
+ * callsPerBody calls of the stage.
+ */
+template <typename Setup, typename Body>
+Timing measure(int iterations, int callsPerBody, Setup setup, Body body)
+{
+    Timing timing = { 0.0, 1e300, 0.0 };
+    for (int i = 0; i < iterations; i++) {
+        setup(i);
+        Clock::time_point start = Clock::now();
+        body(i);
+        double ns = std::chrono::duration<double, std::nano>(Clock::now() - start).count() / callsPerBody;
+        timing.mean += ns;
+        timing.min = min(timing.min, ns);
+        timing.max = max(timing.max, ns);
+    }
+    timing.mean /= iterations;
+    return timing;
+}
+
+/**
+ * Prints one measurement as a JSON object on its own line. params holds the
+ * stage's parameters as JSON members, or is empty.
+ */
+static void report(const char* stage, const char* params, int iterations, Timing timing)
+{
+    printf("{\"stage\": \"%s\", %s%s\"window_size\": %d, \"sample_rate\": %d, \"kernels\": \"%s\", "
+        "\"iterations\": %d, \"mean_ns\": %.1f, \"min_ns\": %.1f, \"max_ns\": %.1f}\n",
+        stage, params, params[0] ? ", " : "", WINDOW_SIZE, SAMPLE_RATE, Kernels::backendName(),
+        iterations, timing.mean, timing.min, timing.max);
+}
+
+/**
+ * Loads enough input for the iterations, plus a spare window: a few tones
+ * with slowly varying amplitudes over white noise, so the spectrum has peaks
+ * for the floors to keep and noise for them to remove.
+ */
+static void loadInput(int iterations)
+{
+    std::vector<float> samples((size_t)(iterations + 1) * WINDOW_SIZE);
+    unsigned int seed = 1;
+    for (size_t i = 0; i < samples.size(); i++) {
+        double t = (double)i / SAMPLE_RATE;
+        seed     = seed * 1103515245 + 12345;
+        float noise = ((seed >> 16) & 0x7FFF) / 16384.0f - 1.0f;
+        samples[i] = 0.3f * sinf(2 * PI * 110 * t) * (0.6f + 0.4f * sinf(2 * PI * 0.5 * t))
+            + 0.2f * sinf(2 * PI * 440 * t) + 0.1f * sinf(2 * PI * 1250 * t) + 0.05f * noise;
+    }
+    AudioLab.loadInput(samples.data(), samples.size());
+}
+
+/**
+ * Times updateGrains with numGrains static grains, all sustaining for longer
+ * than the benchmark runs, on a fresh API.
+ */
+static void benchmarkGrains(int numGrains, int iterations)
+{
+    char params[64];
+    snprintf(params, sizeof(params), "\"grains\": %d", numGrains);
+
+    VibrosonicsAPI* api = new VibrosonicsAPI();
+    Grain* grains = api->createGrainArray(numGrains, 0, SINE);
+    for (int i = 0; i < numGrains; i++) {
+        float freq = 20 + (i * 7) % 200;
+        FreqEnv freqEnv = api->createFreqEnv(freq, freq, freq, freq);
+        AmpEnv ampEnv   = api->createAmpEnv(1, 1, 1, 1);
+        DurEnv durEnv   = api->createDurEnv(4, 4, iterations + 16, 4, 1.0f);
+        api->triggerGrains(&grains[i], 1, freqEnv, ampEnv, durEnv);
+    }
+
+    loadInput(0);
+    Timing timing = measure(iterations, 1,
+        [&](int) { AudioLab.synthesize(); },
+        [&](int) { api->updateGrains(); });
+    report("updateGrains", params, iterations, timing);
+
+    delete api;
+    delete[] grains;
+}
+
+int main(int argc, char** argv)
+{
+    int iterations = argc > 1 ? atoi(argv[1]) : 1000;
+    if (argc > 2 || iterations <= 0) {
+        fprintf(stderr, "usage: %s [iterations]\n", argv[0]);
+        return 1;
+    }
+
+    VibrosonicsAPI* vapi = new VibrosonicsAPI();
+    vapi->init();
+
+    static float spectrum[WINDOW_SIZE_BY_2];
+    static float data[WINDOW_SIZE_BY_2];
+    Timing timing;
+    char params[128];
+
+    // front end, on a new window every iteration
+    loadInput(iterations);
+    timing = measure(iterations, 1,
+        [&](int) { vapi->isAudioLabReady(); },
+        [&](int) { vapi->processAudioInput(spectrum); });
+    report("processAudioInput", "", iterations, timing);
+
+    // floors of the last spectrum, restored before every iteration
+    timing = measure(iterations, 1,
+        [&](int) { memcpy(data, spectrum, sizeof(data)); },
+        [&](int) { vapi->noiseFloor(data, 100); });
+    report("noiseFloor", "", iterations, timing);
+
+    const int cfarSizes[][2] = { { 4, 1 }, { 8, 2 }, { 16, 4 }, { 32, 8 } };
+    const char* cfarNames[] = { "CA_CFAR", "GO_CFAR", "SO_CFAR", "OS_CFAR" };
+    for (int type = CA_CFAR; type <= OS_CFAR; type++) {
+        for (const int* size : cfarSizes) {
+            snprintf(params, sizeof(params), "\"type\": \"%s\", \"numRefs\": %d, \"numGuards\": %d",
+                cfarNames[type], size[0], size[1]);
+            timing = measure(iterations, 1,
+                [&](int) {},
+                [&](int) { vapi->noiseFloorCFAR(spectrum, data, size[0], size[1], 1.4f, (CFARType)type); });
+            report("noiseFloorCFAR", params, iterations, timing);
+        }
+    }
+
+    timing = measure(iterations, 1,
+        [&](int) { memcpy(data, spectrum, sizeof(data)); },
+        [&](int) { vapi->mapAmplitudes(data, WINDOW_SIZE_BY_2); });
+    report("mapAmplitudes", "", iterations, timing);
+
+    timing = measure(iterations, BENCHMARK_BATCH,
+        [&](int) {},
+        [&](int i) {
+            for (int j = 0; j < BENCHMARK_BATCH; j++) {
+                sink = vapi->mapFrequencyMIDI(100 + 31 * ((i + j) % 100), 20, 230);
+            }
+        });
+    report("mapFrequencyMIDI", "", iterations, timing);
+
+    // waves for the peaks of a spectrum, cleared by synthesizing them
+    float peakFreqs[BENCHMARK_PEAKS];
+    float peakAmps[BENCHMARK_PEAKS];
+    for (int i = 0; i < BENCHMARK_PEAKS; i++) {
+        peakFreqs[i] = 20 + i * 6.5f;
+        peakAmps[i]  = 1.0f / BENCHMARK_PEAKS;
+    }
+    snprintf(params, sizeof(params), "\"waves\": %d", BENCHMARK_PEAKS);
+    loadInput(0);
+    timing = measure(iterations, 1,
+        [&](int) { AudioLab.synthesize(); },
+        [&](int) { vapi->assignWaves(peakFreqs, peakAmps, BENCHMARK_PEAKS, 0); });
+    report("assignWaves", params, iterations, timing);
+
+    for (int numGrains : { 1, 10, 100, 1000 }) {
+        benchmarkGrains(numGrains, iterations);
+    }
+
+    delete vapi;
+    return 0;
+}
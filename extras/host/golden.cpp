@@ -0,0 +1,397 @@
+/**
+ * @file golden.cpp
+ *
+ * Golden output harness: runs deterministic synthetic signals through the
+ * public VibrosonicsAPI calls and records what each stage produced, or
+ * compares it against a previous recording within per-stage tolerances.
+ *
+ * For every window of every signal it keeps:
+ *
+ * - spectrum: the magnitudes from processAudioInput.
+ * - cfar: the spectrum floored by noiseFloorCFAR.
+ * - waves: the waves assignWaves created for the strongest peaks, after
+ *   refinePeaks, mapAmplitudes and mapFrequencyMIDI.
+ * - grains: the waves updateGrains created for dynamic grains triggered on
+ *   the strongest peak every few windows.
+ *
+ * Golden files for the default host configuration, Config.h with the stub
+ * FFT, are kept in the golden folder next to this file, which both commands
+ * use unless given another folder. Record golden files before a change that
+ * should not alter the output, then check against them after it:
+ *
+ *     ./golden record [dir]
+ *     ./golden check [dir] [stage=tolerance ...]
+ *
+ * check prints the largest error of every signal and stage and exits with 1
+ * if any exceeds its tolerance. Golden files hold results for the
+ * WINDOW_SIZE and SAMPLE_RATE they were recorded with and are refused by a
+ * build with other values.
+ *
+ * Both commands also check that every processAudioInput consumes the hop of
+ * the window it transforms, and fail if any hop is left pending. A build
+ * with VIBROSONICS_FIXED_POINT runs the same checks, against golden files
+ * recorded by a fixed-point build of the same sample format.
+ */
+
+#include <Arduino.h>
+#include <AudioLab.h>
+
+#include <algorithm>
+#include <cstdlib>
+#include <filesystem>
+#include <string>
+#include <vector>
+
+#include "VibrosonicsAPI.h"
+
+//! Number of windows each signal runs for
+#define GOLDEN_WINDOWS 48
+
+//! Number of peaks turned into waves every window
+#define GOLDEN_PEAKS 8
+
+//! Windows between grains triggered on the strongest peak
+#define GOLDEN_GRAIN_INTERVAL 4
+
+#ifndef GOLDEN_DIR
+//! Folder of the golden files used when none is given, set by CMakeLists.txt
+//! to the golden folder of the source tree
+#define GOLDEN_DIR "golden"
+#endif
+
+/**
+ * @type stageKind
+ *
+ * How the rows of a stage are compared.
+ */
+enum stageKind {
+  STAGE_SPECTRUM, //!< Magnitudes, relative to the largest of the golden row
+  STAGE_WAVES     //!< A wave count, then a frequency and amplitude per wave
+};
+
+/**
+ * A recorded stage and how far a check may stray from its golden rows.
+ */
+struct Stage {
+  const char* name;
+  stageKind   kind;
+  //! Largest error relative to the row's largest magnitude or amplitude
+  double      tolerance;
+  //! Largest frequency error of a wave in Hz
+  double      freqTolerance;
+};
+
+static Stage stages[] = {
+    { "spectrum", STAGE_SPECTRUM, 1e-4, 0.0 },
+    { "cfar", STAGE_SPECTRUM, 1e-3, 0.0 },
+    { "waves", STAGE_WAVES, 1e-3, 0.05 },
+    { "grains", STAGE_WAVES, 1e-4, 0.01 },
+};
+
+static const int NUM_STAGES = sizeof(stages) / sizeof(stages[0]);
+
+typedef std::vector<std::vector<double>> Rows;
+
+static const char* signalNames[] = { "sine", "chirp", "impulses", "bursts" };
+
+static const int NUM_SIGNALS = sizeof(signalNames) / sizeof(signalNames[0]);
+
+/**
+ * Generates one of the test signals, GOLDEN_WINDOWS windows long.
+ *
+ * - sine: 110 Hz and 440 Hz tones with a weaker 1250 Hz tone.
+ * - chirp: a tone sweeping linearly from 40 Hz to a quarter of SAMPLE_RATE.
+ * - impulses: single sample clicks every 0.15 s.
+ * - bursts: 80 ms of white noise every 250 ms, over a quiet 200 Hz tone.
+ */
+static std::vector<float> generateSignal(int signal)
+{
+    std::vector<float> samples((size_t)GOLDEN_WINDOWS * WINDOW_SIZE);
+    double duration = (double)samples.size() / SAMPLE_RATE;
+    double endFreq  = SAMPLE_RATE / 4.0;
+    unsigned int seed = 12345;
+    for (size_t i = 0; i < samples.size(); i++) {
+        double t = (double)i / SAMPLE_RATE;
+        switch (signal) {
+        case 0:
+            samples[i] = 0.3 * sin(2 * PI * 110 * t) + 0.2 * sin(2 * PI * 440 * t) + 0.05 * sin(2 * PI * 1250 * t);
+            break;
+        case 1:
+            samples[i] = 0.5 * sin(2 * PI * (40 * t + (endFreq - 40) * t * t / (2 * duration)));
+            break;
+        case 2:
+            samples[i] = i % (size_t)(0.15 * SAMPLE_RATE) == 0 ? 0.9f : 0.0f;
+            break;
+        default:
+            seed = seed * 1103515245 + 12345;
+            samples[i] = 0.05 * sin(2 * PI * 200 * t);
+            if (fmod(t, 0.25) < 0.08) {
+                samples[i] += 0.6f * (((seed >> 16) & 0x7FFF) / 16384.0f - 1.0f);
+            }
+            break;
+        }
+    }
+    return samples;
+}
+
+/**
+ * Appends the waves AudioLab holds for the window as a row: their count,
+ * then the frequency and amplitude of each, and clears them.
+ */
+static void recordWaves(Rows& rows)
+{
+    std::vector<double> row(1, AudioLab.getNumWaves());
+    const wave* waves = AudioLab.getWaves();
+    for (int i = 0; i < AudioLab.getNumWaves(); i++) {
+        row.push_back(waves[i].getFrequency());
+        row.push_back(waves[i].getAmplitude());
+    }
+    rows.push_back(row);
+    AudioLab.synthesize();
+}
+
+/**
+ * Runs a signal through a fresh API and returns the rows of every stage.
+ *
+ * @return false if processAudioInput left a hop of a window pending.
+ */
+static bool runSignal(int signal, Rows results[NUM_STAGES])
+{
+    std::vector<float> samples = generateSignal(signal);
+    AudioLab.loadInput(samples.data(), samples.size());
+
+    VibrosonicsAPI* vapi = new VibrosonicsAPI();
+    vapi->init();
+
+    static float spectrum[WINDOW_SIZE_BY_2];
+    static float floored[WINDOW_SIZE_BY_2];
+    bool hopsConsumed = true;
+    for (int window = 0; vapi->isAudioLabReady(); window++) {
+        vapi->processAudioInput(spectrum);
+        if (vapi->getPendingHops() != 0) {
+            fprintf(stderr, "Error: %s window %d has %d hops pending after processAudioInput\n",
+                signalNames[signal], window, vapi->getPendingHops());
+            hopsConsumed = false;
+        }
+        results[0].push_back(std::vector<double>(spectrum, spectrum + WINDOW_SIZE_BY_2));
+
+        vapi->noiseFloorCFAR(spectrum, floored, 8, 2, 1.4f, CA_CFAR);
+        results[1].push_back(std::vector<double>(floored, floored + WINDOW_SIZE_BY_2));
+
+        // strongest local maxima of the floored spectrum, loudest first
+        std::vector<int> peaks;
+        for (int i = 1; i < WINDOW_SIZE_BY_2 - 1; i++) {
+            if (floored[i] > 0 && floored[i] > floored[i - 1] && floored[i] >= floored[i + 1]) {
+                peaks.push_back(i);
+            }
+        }
+        std::stable_sort(peaks.begin(), peaks.end(), [&](int a, int b) { return floored[a] > floored[b]; });
+        int numPeaks = min((int)peaks.size(), GOLDEN_PEAKS);
+
+        float binFreqs[GOLDEN_PEAKS];
+        float freqs[GOLDEN_PEAKS];
+        float amps[GOLDEN_PEAKS];
+        for (int i = 0; i < numPeaks; i++) {
+            binFreqs[i] = peaks[i] * FREQ_RES;
+        }
+        vapi->refinePeaks(spectrum, binFreqs, freqs, amps, numPeaks, PEAK_GAUSSIAN);
+        float loudestFreq = numPeaks > 0 ? freqs[0] : 0.0f;
+        vapi->mapAmplitudes(amps, numPeaks, 1000);
+        for (int i = 0; i < numPeaks; i++) {
+            freqs[i] = vapi->mapFrequencyMIDI(freqs[i], 20, 230);
+        }
+        vapi->assignWaves(freqs, amps, numPeaks, 0);
+        recordWaves(results[2]);
+
+        if (numPeaks > 0 && window % GOLDEN_GRAIN_INTERVAL == 0) {
+            float freq = vapi->mapFrequencyMIDI(loudestFreq, 20, 230);
+            FreqEnv freqEnv = vapi->createFreqEnv(freq, freq * 1.1f, freq, freq * 0.9f);
+            AmpEnv ampEnv;
+            ampEnv.attackAmplitude  = 1.0f;
+            ampEnv.decayAmplitude   = 0.7f;
+            ampEnv.sustainAmplitude = 0.5f;
+            ampEnv.releaseAmplitude = 0.0f;
+            DurEnv durEnv = vapi->createDurEnv(2, 3, 4, 6, 2.0f);
+            vapi->createDynamicGrain(1, SINE, freqEnv, ampEnv, durEnv);
+        }
+        vapi->updateGrains();
+        recordWaves(results[3]);
+    }
+
+    delete vapi;
+    return hopsConsumed;
+}
+
+static std::string goldenPath(const std::string& dir, int signal, int stage)
+{
+    return dir + "/" + signalNames[signal] + "." + stages[stage].name + ".txt";
+}
+
+/**
+ * Writes rows as one line of values each, after a header naming the build
+ * they came from.
+ */
+static bool writeRows(const std::string& path, const Rows& rows)
+{
+    FILE* file = fopen(path.c_str(), "w");
+    if (!file) {
+        fprintf(stderr, "Error: could not write %s\n", path.c_str());
+        return false;
+    }
+    fprintf(file, "# window_size %d sample_rate %d\n", WINDOW_SIZE, SAMPLE_RATE);
+    for (const std::vector<double>& row : rows) {
+        for (size_t i = 0; i < row.size(); i++) {
+            fprintf(file, i ? " %.9g" : "%.9g", row[i]);
+        }
+        fputc('\n', file);
+    }
+    fclose(file);
+    return true;
+}
+
+/**
+ * Reads rows written by writeRows, refusing files from a build with another
+ * window size or sample rate.
+ */
+static bool readRows(const std::string& path, Rows& rows)
+{
+    FILE* file = fopen(path.c_str(), "r");
+    if (!file) {
+        fprintf(stderr, "Error: could not read %s\n", path.c_str());
+        return false;
+    }
+    int windowSize = 0, sampleRate = 0;
+    if (fscanf(file, "# window_size %d sample_rate %d", &windowSize, &sampleRate) != 2
+        || windowSize != WINDOW_SIZE || sampleRate != SAMPLE_RATE) {
+        fprintf(stderr, "Error: %s was not recorded with WINDOW_SIZE %d and SAMPLE_RATE %d\n", path.c_str(),
+            WINDOW_SIZE, SAMPLE_RATE);
+        fclose(file);
+        return false;
+    }
+
+    std::string line;
+    int c;
+    while ((c = fgetc(file)) != EOF) {
+        if (c != '\n') {
+            line += (char)c;
+            continue;
+        }
+        if (!line.empty()) {
+            std::vector<double> row;
+            const char* text = line.c_str();
+            char* end;
+            for (double value = strtod(text, &end); end != text; value = strtod(text, &end)) {
+                row.push_back(value);
+                text = end;
+            }
+            rows.push_back(row);
+        }
+        line.clear();
+    }
+    fclose(file);
+    return true;
+}
+
+/**
+ * Returns the largest error of the rows against the golden rows, relative to
+ * each golden row's largest magnitude or amplitude, or infinity if their
+ * shapes differ or a wave's frequency is off by more than the stage allows.
+ */
+static double compareRows(const Stage& stage, const Rows& rows, const Rows& golden)
+{
+    if (rows.size() != golden.size()) {
+        return INFINITY;
+    }
+
+    double worst = 0.0;
+    for (size_t r = 0; r < rows.size(); r++) {
+        const std::vector<double>& row = rows[r];
+        const std::vector<double>& ref = golden[r];
+        if (row.size() != ref.size() || (stage.kind == STAGE_WAVES && row[0] != ref[0])) {
+            return INFINITY;
+        }
+
+        // values are spectrum bins, or the amplitudes after a wave count
+        size_t first = stage.kind == STAGE_WAVES ? 2 : 0;
+        size_t step  = stage.kind == STAGE_WAVES ? 2 : 1;
+        double scale = 0.0;
+        for (size_t i = first; i < ref.size(); i += step) {
+            scale = max(scale, fabs(ref[i]));
+        }
+        scale = max(scale, 1e-9);
+
+        for (size_t i = first; i < ref.size(); i += step) {
+            worst = max(worst, fabs(row[i] - ref[i]) / scale);
+        }
+        for (size_t i = 1; stage.kind == STAGE_WAVES && i < ref.size(); i += 2) {
+            if (fabs(row[i] - ref[i]) > stage.freqTolerance) {
+                return INFINITY;
+            }
+        }
+    }
+    return worst;
+}
+
+int main(int argc, char** argv)
+{
+    bool record = argc >= 2 && strcmp(argv[1], "record") == 0;
+    bool check  = argc >= 2 && strcmp(argv[1], "check") == 0;
+    if (!record && !check) {
+        fprintf(stderr, "usage: %s record [dir]\n       %s check [dir] [stage=tolerance ...]\n", argv[0], argv[0]);
+        return 1;
+    }
+    std::string dir   = GOLDEN_DIR;
+    int         first = 2;
+    if (argc > 2 && !strchr(argv[2], '=')) {
+        dir   = argv[2];
+        first = 3;
+    }
+    if (record) {
+        std::error_code error;
+        std::filesystem::create_directories(dir, error);
+        if (error) {
+            fprintf(stderr, "Error: could not create %s: %s\n", dir.c_str(), error.message().c_str());
+            return 1;
+        }
+    }
+
+    for (int i = first; i < argc; i++) {
+        std::string arg    = argv[i];
+        size_t      equals = arg.find('=');
+        int         stage  = 0;
+        while (stage < NUM_STAGES && arg.substr(0, equals) != stages[stage].name) {
+            stage++;
+        }
+        if (equals == std::string::npos || stage == NUM_STAGES) {
+            fprintf(stderr, "Error: expected stage=tolerance, got %s\n", argv[i]);
+            return 1;
+        }
+        stages[stage].tolerance = atof(arg.c_str() + equals + 1);
+    }
+
+    bool passed = true;
+    for (int signal = 0; signal < NUM_SIGNALS; signal++) {
+        Rows results[NUM_STAGES];
+        passed &= runSignal(signal, results);
+
+        for (int stage = 0; stage < NUM_STAGES; stage++) {
+            std::string path = goldenPath(dir, signal, stage);
+            if (record) {
+                passed &= writeRows(path, results[stage]);
+                continue;
+            }
+
+            Rows golden;
+            if (!readRows(path, golden)) {
+                passed = false;
+                continue;
+            }
+            double error = compareRows(stages[stage], results[stage], golden);
+            bool   ok    = error <= stages[stage].tolerance;
+            printf("%-8s %-8s max error %-10.3g tolerance %-8.3g %s\n", signalNames[signal], stages[stage].name,
+                error, stages[stage].tolerance, ok ? "ok" : "FAILED");
+            passed &= ok;
+        }
+    }
+    return passed ? 0 : 1;
+}
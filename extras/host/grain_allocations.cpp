@@ -0,0 +1,144 @@
+/**
+ * @file grain_allocations.cpp
+ *
+ * Checks that dynamic grains never allocate memory once a sketch is set up.
+ *
+ * The global operator new and operator delete are replaced with versions
+ * that count their calls. After a setup like a sketch's, which creates the
+ * API and some static grains, the program runs GRAIN_WINDOWS windows of a
+ * percussion-style loop: hits trigger bursts of short dynamic grains, some
+ * larger than GRAIN_POOL_SIZE so that grains are stolen under every steal
+ * policy, and updateGrains runs every window. It exits with 1 if either count
+ * rose after setup.
+ *
+ *     ./grain_allocations
+ */
+
+#include <Arduino.h>
+#include <AudioLab.h>
+
+#include <cstdlib>
+#include <new>
+#include <vector>
+
+#include "VibrosonicsAPI.h"
+
+//! Number of windows the loop runs for
+#define GRAIN_WINDOWS 4000
+
+static unsigned long numNews    = 0;
+static unsigned long numDeletes = 0;
+
+void* operator new(size_t size)
+{
+    numNews++;
+    void* memory = malloc(size ? size : 1);
+    if (!memory) {
+        throw std::bad_alloc();
+    }
+    return memory;
+}
+
+void* operator new[](size_t size)
+{
+    return operator new(size);
+}
+
+void* operator new(size_t size, const std::nothrow_t&) noexcept
+{
+    numNews++;
+    return malloc(size ? size : 1);
+}
+
+void* operator new[](size_t size, const std::nothrow_t&) noexcept
+{
+    return operator new(size, std::nothrow);
+}
+
+void operator delete(void* memory) noexcept
+{
+    if (memory) {
+        numDeletes++;
+    }
+    free(memory);
+}
+
+void operator delete[](void* memory) noexcept
+{
+    operator delete(memory);
+}
+
+void operator delete(void* memory, size_t) noexcept
+{
+    operator delete(memory);
+}
+
+void operator delete[](void* memory, size_t) noexcept
+{
+    operator delete(memory);
+}
+
+/**
+ * Triggers a hit: a burst of short triangle grains on both channels, like
+ * the Percussion example's, with a length that varies from hit to hit.
+ */
+static void triggerHit(VibrosonicsAPI* api, int window, int numGrains)
+{
+    float   freq    = 40 + (window * 13) % 160;
+    float   amp     = 0.2f + (window % 7) * 0.1f;
+    FreqEnv freqEnv = api->createFreqEnv(freq, freq, freq, freq);
+    AmpEnv  ampEnv  = api->createAmpEnv(amp, amp, 0.3f * amp, 0.0f);
+    DurEnv  durEnv  = api->createDurEnv(1, 0, 1 + window % 3, 3 + window % 5, 1.0f + (window % 4) * 0.5f);
+    for (int i = 0; i < numGrains; i++) {
+        api->createDynamicGrain(i % 2, TRIANGLE, freqEnv, ampEnv, durEnv);
+    }
+}
+
+int main()
+{
+    // setup: the API, static grains and the input are all allocated here
+    VibrosonicsAPI* api     = new VibrosonicsAPI();
+    Grain*          statics = api->createGrainArray(4, 0, SINE);
+    for (int i = 0; i < 4; i++) {
+        FreqEnv freqEnv = api->createFreqEnv(30 + 10 * i, 30 + 10 * i, 30 + 10 * i, 30 + 10 * i);
+        AmpEnv  ampEnv  = api->createAmpEnv(0.5f, 0.5f, 0.5f, 0.5f);
+        DurEnv  durEnv  = api->createDurEnv(2, 2, 8, 2, 1.0f);
+        api->triggerGrains(&statics[i], 1, freqEnv, ampEnv, durEnv);
+    }
+
+    std::vector<float> samples((size_t)(GRAIN_WINDOWS + 1) * WINDOW_SIZE);
+    for (size_t i = 0; i < samples.size(); i++) {
+        samples[i] = 0.3f * sinf(2 * PI * 220 * i / SAMPLE_RATE);
+    }
+    AudioLab.loadInput(samples.data(), samples.size());
+
+    unsigned long setupNews    = numNews;
+    unsigned long setupDeletes = numDeletes;
+
+    const grainStealPolicy policies[] = { STEAL_OLDEST, STEAL_QUIETEST, STEAL_NONE };
+    for (int window = 0; window < GRAIN_WINDOWS; window++) {
+        if (!api->isAudioLabReady()) {
+            fprintf(stderr, "Error: input ran out after %d windows\n", window);
+            return 1;
+        }
+        api->processAudioInput();
+
+        api->setGrainStealPolicy(policies[window / 500 % 3]);
+        if (window % 3 == 0) {
+            triggerHit(api, window, 2);
+        }
+        if (window % 50 == 0) {
+            triggerHit(api, window, GRAIN_POOL_SIZE + 8);
+        }
+        api->updateGrains();
+        AudioLab.synthesize();
+    }
+
+    unsigned long news    = numNews - setupNews;
+    unsigned long deletes = numDeletes - setupDeletes;
+    printf("%d windows: %lu allocations, %lu frees after setup\n", GRAIN_WINDOWS, news, deletes);
+
+    delete api;
+    delete[] statics;
+    return news == 0 && deletes == 0 ? 0 : 1;
+}
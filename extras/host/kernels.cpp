@@ -0,0 +1,204 @@
+/**
+ * @file kernels.cpp
+ *
+ * Checks every kernel of the backend the host build picked against
+ * Kernels::Reference.
+ *
+ * Each kernel runs over every length up to KERNEL_LENGTHS and a few longer
+ * odd ones, starting at every offset within a vector so that both aligned
+ * and unaligned arrays and every tail are covered, with the output apart
+ * from the inputs and aliased to each of them. Element-wise kernels must
+ * match the reference exactly and must not write past the end of the
+ * output; sums and dot products, which the vector backends accumulate in
+ * another order, must match within the rounding error of the sum. Exits with
+ * 1 on any mismatch.
+ *
+ *     ./kernels
+ */
+
+#include <Arduino.h>
+#include <AudioLab.h>
+
+#include <cfloat>
+#include <cmath>
+#include <random>
+#include <vector>
+
+#include "Kernels.h"
+
+//! Every length from 0 to this one is checked
+#define KERNEL_LENGTHS 40
+
+//! Number of offsets from an aligned start each array is checked at
+#define KERNEL_OFFSETS 8
+
+//! Value past the end of the output that no kernel may overwrite
+#define KERNEL_GUARD 1234.5f
+
+typedef void (*BinaryKernel)(const float*, const float*, float*, int);
+typedef void (*UnaryKernel)(const float*, float, float*, int);
+
+//! Ways the output of a kernel can share memory with its inputs
+enum aliasing { OUT_APART, OUT_IS_A, OUT_IS_B, ALL_SHARED };
+
+static const char* aliasingNames[] = { "apart", "out = a", "out = b", "out = a = b" };
+
+static std::mt19937 generator(1);
+static int          failures = 0;
+
+/**
+ * Fills an array with values from -1 to 1, with some exact zeros and some
+ * repeated values so that ties and thresholds are hit.
+ */
+static void fill(float* values, int length)
+{
+    std::uniform_real_distribution<float> uniform(-1.0f, 1.0f);
+    for (int i = 0; i < length; i++) {
+        int kind  = generator() % 8;
+        values[i] = kind == 0 ? 0.0f : kind == 1 && i > 0 ? values[i - 1] : uniform(generator);
+    }
+}
+
+static void fail(const char* kernel, int length, int offset, const char* how)
+{
+    if (failures++ < 20) {
+        fprintf(stderr, "Error: %s differs from the reference (length %d, offset %d, %s)\n",
+            kernel, length, offset, how);
+    }
+}
+
+/**
+ * Runs a kernel and its reference on copies of the same inputs, aliased the
+ * same way, and compares the outputs and the guard after them.
+ */
+static void checkBinary(const char* name, BinaryKernel kernel, BinaryKernel reference,
+    int length, int offset)
+{
+    for (int alias = OUT_APART; alias <= ALL_SHARED; alias++) {
+        std::vector<float> inputs(2 * (length + KERNEL_OFFSETS + 1));
+        fill(inputs.data(), inputs.size());
+
+        float* results[2];
+        std::vector<float> buffers[2];
+        for (int run = 0; run < 2; run++) {
+            // a, b and out, each with room for the offset and a guard value
+            buffers[run] = std::vector<float>(3 * (length + KERNEL_OFFSETS + 1));
+            float* a   = buffers[run].data() + offset;
+            float* b   = a + length + KERNEL_OFFSETS + 1;
+            float* out = b + length + KERNEL_OFFSETS + 1;
+            std::copy(inputs.begin(), inputs.begin() + length, a);
+            std::copy(inputs.begin() + length, inputs.begin() + 2 * length, b);
+
+            if (alias == OUT_IS_A) {
+                out = a;
+            } else if (alias == OUT_IS_B) {
+                out = b;
+            } else if (alias == ALL_SHARED) {
+                out = b = a;
+            }
+            a[length] = b[length] = out[length] = KERNEL_GUARD;
+
+            (run == 0 ? kernel : reference)(a, b, out, length);
+            results[run] = out;
+        }
+
+        for (int i = 0; i <= length; i++) {
+            if (results[0][i] != results[1][i]) {
+                fail(name, length, offset, i == length ? "wrote past the end" : aliasingNames[alias]);
+                break;
+            }
+        }
+    }
+}
+
+static void checkUnary(const char* name, UnaryKernel kernel, UnaryKernel reference, float argument,
+    int length, int offset)
+{
+    for (int alias = OUT_APART; alias <= OUT_IS_A; alias++) {
+        std::vector<float> inputs(length + 1);
+        fill(inputs.data(), inputs.size());
+
+        float* results[2];
+        std::vector<float> buffers[2];
+        for (int run = 0; run < 2; run++) {
+            buffers[run] = std::vector<float>(2 * (length + KERNEL_OFFSETS + 1));
+            float* in  = buffers[run].data() + offset;
+            float* out = alias == OUT_IS_A ? in : in + length + KERNEL_OFFSETS + 1;
+            std::copy(inputs.begin(), inputs.begin() + length, in);
+            out[length] = KERNEL_GUARD;
+
+            (run == 0 ? kernel : reference)(in, argument, out, length);
+            results[run] = out;
+        }
+
+        for (int i = 0; i <= length; i++) {
+            if (results[0][i] != results[1][i]) {
+                fail(name, length, offset, i == length ? "wrote past the end" : aliasingNames[alias]);
+                break;
+            }
+        }
+    }
+}
+
+/**
+ * Compares a sum or dot product with the reference, allowing the rounding
+ * error of summing length terms in any order.
+ */
+static void checkTotal(const char* name, float total, float expected, float magnitude,
+    int length, int offset)
+{
+    float tolerance = 2.0f * length * FLT_EPSILON * magnitude + FLT_MIN;
+    if (!(fabsf(total - expected) <= tolerance)) {
+        fail(name, length, offset, "outside the rounding error");
+    }
+}
+
+static void checkTotals(int length, int offset)
+{
+    std::vector<float> buffer(2 * (length + KERNEL_OFFSETS));
+    float* a = buffer.data() + offset;
+    float* b = a + length + KERNEL_OFFSETS;
+    fill(a, length);
+    fill(b, length);
+
+    float absSum = 0.0f;
+    float absDot = 0.0f;
+    for (int i = 0; i < length; i++) {
+        absSum += fabsf(a[i]);
+        absDot += fabsf(a[i] * b[i]);
+    }
+    checkTotal("sum", Kernels::sum(a, length), Kernels::Reference::sum(a, length), absSum, length, offset);
+    checkTotal("dot", Kernels::dot(a, b, length), Kernels::Reference::dot(a, b, length), absDot, length,
+        offset);
+    checkTotal("dot (a = b)", Kernels::dot(a, a, length), Kernels::Reference::dot(a, a, length),
+        Kernels::Reference::dot(a, a, length), length, offset);
+}
+
+int main()
+{
+    std::vector<int> lengths;
+    for (int length = 0; length <= KERNEL_LENGTHS; length++) {
+        lengths.push_back(length);
+    }
+    for (int length : { 63, 65, 127, 129, WINDOW_SIZE / 2 - 1, WINDOW_SIZE / 2 + 1, 1023 }) {
+        lengths.push_back(length);
+    }
+
+    for (int length : lengths) {
+        for (int offset = 0; offset < KERNEL_OFFSETS; offset++) {
+            checkBinary("add", Kernels::add, Kernels::Reference::add, length, offset);
+            checkBinary("subtract", Kernels::subtract, Kernels::Reference::subtract, length, offset);
+            checkBinary("maximum", Kernels::maximum, Kernels::Reference::maximum, length, offset);
+            checkBinary("minimum", Kernels::minimum, Kernels::Reference::minimum, length, offset);
+            checkUnary("scale", Kernels::scale, Kernels::Reference::scale, 0.37f, length, offset);
+            checkUnary("threshold", Kernels::threshold, Kernels::Reference::threshold, 0.1f, length, offset);
+            checkUnary("threshold at 0", Kernels::threshold, Kernels::Reference::threshold, 0.0f, length,
+                offset);
+            checkTotals(length, offset);
+        }
+    }
+
+    printf("%s kernels: %zu lengths, %d offsets, %d mismatches\n", Kernels::backendName(), lengths.size(),
+        KERNEL_OFFSETS, failures);
+    return failures == 0 ? 0 : 1;
+}
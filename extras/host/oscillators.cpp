@@ -0,0 +1,173 @@
+/**
+ * @file oscillators.cpp
+ *
+ * Checks that an OscillatorBank renders without steps at window boundaries
+ * and without aliasing.
+ *
+ * - Continuity: with constant targets, every shape rendered one window at a
+ *   time must equal the same oscillator rendered in a single call, so the
+ *   phase carries over exactly. With the frequency and amplitude changing
+ *   every window, the step from the last sample of a window to the first of
+ *   the next must be no larger than the largest step inside either window.
+ * - Band limits: every band-limited shape is rendered at frequencies from
+ *   the bottom to the top of the range, each a whole number of DFT bins so
+ *   its harmonics land on bins that are multiples of its own. A harmonic
+ *   above the Nyquist frequency folds back onto some other bin, so every
+ *   other bin must stay below OSCILLATOR_ALIAS_LIMIT.
+ *
+ * Exits with 1 if any check fails.
+ *
+ *     ./oscillators
+ */
+
+#include <Arduino.h>
+#include <AudioLab.h>
+
+#include <cmath>
+#include <vector>
+
+#include "OscillatorBank.h"
+
+//! Windows rendered by each continuity check
+#define OSCILLATOR_WINDOWS 64
+
+//! Samples in the DFT of the band limit check
+#define OSCILLATOR_DFT_SIZE 4096
+
+//! Largest amplitude allowed off the harmonics of a band-limited wave, which
+//! leaves room for the images of linear interpolation
+#define OSCILLATOR_ALIAS_LIMIT 0.01f
+
+static const WaveType types[]     = { SINE, COSINE, TRIANGLE, SQUARE, SAWTOOTH };
+static const char*    typeNames[] = { "SINE", "COSINE", "TRIANGLE", "SQUARE", "SAWTOOTH" };
+
+static int failures = 0;
+
+/**
+ * Renders one oscillator with constant targets window by window and in a
+ * single call, after a window in which both ramp up to the targets.
+ */
+static void checkConstant(int t, float freq)
+{
+    OscillatorBank windowed;
+    OscillatorBank whole;
+    windowed.addOscillator(0, types[t]);
+    whole.addOscillator(0, types[t]);
+    windowed.setOscillator(0, freq, 0.8f);
+    whole.setOscillator(0, freq, 0.8f);
+
+    std::vector<float> first(WINDOW_SIZE);
+    windowed.render(first.data(), WINDOW_SIZE, 1);
+    whole.render(first.data(), WINDOW_SIZE, 1);
+
+    std::vector<float> expected(OSCILLATOR_WINDOWS * WINDOW_SIZE);
+    std::vector<float> rendered(OSCILLATOR_WINDOWS * WINDOW_SIZE);
+    whole.render(expected.data(), expected.size(), 1);
+    for (int w = 0; w < OSCILLATOR_WINDOWS; w++) {
+        windowed.render(rendered.data() + w * WINDOW_SIZE, WINDOW_SIZE, 1);
+    }
+
+    if (rendered != expected) {
+        fprintf(stderr, "Error: %s at %g Hz differs when rendered window by window\n", typeNames[t], freq);
+        failures++;
+    }
+}
+
+/**
+ * Renders one oscillator whose frequency and amplitude change every window
+ * and compares the steps across window boundaries with those inside.
+ */
+static void checkRamps(int t)
+{
+    OscillatorBank bank;
+    bank.addOscillator(0, types[t]);
+
+    std::vector<float> output(OSCILLATOR_WINDOWS * WINDOW_SIZE);
+    for (int w = 0; w < OSCILLATOR_WINDOWS; w++) {
+        bank.setOscillator(0, 30 + 25 * (w % 7), 0.2f + 0.1f * (w % 5));
+        bank.render(output.data() + w * WINDOW_SIZE, WINDOW_SIZE, 1);
+    }
+
+    std::vector<float> largestStep(OSCILLATOR_WINDOWS, 0.0f);
+    for (int w = 0; w < OSCILLATOR_WINDOWS; w++) {
+        for (int i = w * WINDOW_SIZE + 1; i < (w + 1) * WINDOW_SIZE; i++) {
+            largestStep[w] = max(largestStep[w], fabsf(output[i] - output[i - 1]));
+        }
+    }
+    for (int w = 1; w < OSCILLATOR_WINDOWS; w++) {
+        int   i     = w * WINDOW_SIZE;
+        float step  = fabsf(output[i] - output[i - 1]);
+        float limit = 1.01f * max(largestStep[w - 1], largestStep[w]) + 1e-6f;
+        if (step > limit) {
+            fprintf(stderr, "Error: %s steps by %g at the start of window %d, at most %g inside\n",
+                typeNames[t], step, w, limit);
+            failures++;
+            return;
+        }
+    }
+}
+
+/**
+ * Renders a band-limited shape at a frequency of a whole number of bins and
+ * returns the largest amplitude of the bins that are not its harmonics.
+ */
+static float largestAlias(int t, int bin, const std::vector<double>& cosine)
+{
+    OscillatorBank bank;
+    bank.addOscillator(0, types[t]);
+    float freq = (float)bin * SAMPLE_RATE / OSCILLATOR_DFT_SIZE;
+    bank.setOscillator(0, freq, 1.0f);
+
+    std::vector<float> output(OSCILLATOR_DFT_SIZE);
+    bank.render(output.data(), WINDOW_SIZE, 1);
+    bank.render(output.data(), OSCILLATOR_DFT_SIZE, 1);
+
+    float largest = 0.0f;
+    for (int k = 1; k < OSCILLATOR_DFT_SIZE / 2; k++) {
+        if (k % bin == 0) {
+            continue;
+        }
+        double re = 0.0;
+        double im = 0.0;
+        for (int i = 0; i < OSCILLATOR_DFT_SIZE; i++) {
+            int phase = (int)((long)k * i % OSCILLATOR_DFT_SIZE);
+            re += output[i] * cosine[phase];
+            im += output[i] * cosine[(phase + OSCILLATOR_DFT_SIZE * 3 / 4) % OSCILLATOR_DFT_SIZE];
+        }
+        largest = max(largest, (float)(2.0 * sqrt(re * re + im * im) / OSCILLATOR_DFT_SIZE));
+    }
+    return largest;
+}
+
+int main()
+{
+    for (int t = 0; t < 5; t++) {
+        for (float freq : { 41.0f, 440.0f, 1234.5f, SAMPLE_RATE / 3.0f }) {
+            checkConstant(t, freq);
+        }
+        checkRamps(t);
+    }
+
+    std::vector<double> cosine(OSCILLATOR_DFT_SIZE);
+    for (int i = 0; i < OSCILLATOR_DFT_SIZE; i++) {
+        cosine[i] = cos(2 * M_PI * i / OSCILLATOR_DFT_SIZE);
+    }
+
+    // odd bins, so harmonics folded back never land on a multiple of the bin;
+    // from below the richest table's range up to a few harmonics below Nyquist
+    float worst = 0.0f;
+    for (int t = 2; t < 5; t++) {
+        for (int bin : { 15, 33, 61, 127, 255, 401, 511, 683, 1023, 1365, 1901 }) {
+            float alias = largestAlias(t, bin, cosine);
+            worst       = max(worst, alias);
+            if (alias > OSCILLATOR_ALIAS_LIMIT) {
+                fprintf(stderr, "Error: %s at %g Hz aliases with an amplitude of %g\n", typeNames[t],
+                    (float)bin * SAMPLE_RATE / OSCILLATOR_DFT_SIZE, alias);
+                failures++;
+            }
+        }
+    }
+
+    printf("oscillators: largest alias %g, %d failures\n", worst, failures);
+    return failures == 0 ? 0 : 1;
+}
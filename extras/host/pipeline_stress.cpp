@@ -0,0 +1,128 @@
+/**
+ * @file pipeline_stress.cpp
+ *
+ * Stress test of the pipelined front end on the host, where it runs on a
+ * std::thread. Best built with ThreadSanitizer, see README.md.
+ *
+ * The same PIPELINE_WINDOWS windows of input are first transformed one by one
+ * with processAudioInput, then run through startPipeline while the consumer
+ * spends a random amount of time on every spectrum, so the ring runs both
+ * empty and full. Every acquired spectrum must equal the single-threaded
+ * spectrum of its window, in order, getSpectrum(0) must keep the previously
+ * released one, and the windows consumed plus the windows dropped must add
+ * up to all of them. Exits with 1 otherwise.
+ *
+ *     ./pipeline_stress
+ */
+
+#include <Arduino.h>
+#include <AudioLab.h>
+
+#include <chrono>
+#include <cstring>
+#include <random>
+#include <thread>
+#include <vector>
+
+#include "VibrosonicsAPI.h"
+
+//! Number of windows run through the pipeline
+#define PIPELINE_WINDOWS 3000
+
+//! Seconds the consumer waits for the front end to make progress
+#define PIPELINE_TIMEOUT 10
+
+static bool sameSpectrum(const float* a, const float* b)
+{
+    return memcmp(a, b, WINDOW_SIZE_BY_2 * sizeof(float)) == 0;
+}
+
+int main()
+{
+    // a tone that changes every window, so each spectrum is told apart
+    std::vector<float> input((size_t)PIPELINE_WINDOWS * WINDOW_SIZE);
+    for (int w = 0; w < PIPELINE_WINDOWS; w++) {
+        for (int i = 0; i < WINDOW_SIZE; i++) {
+            input[(size_t)w * WINDOW_SIZE + i] = 0.5f * sinf(2 * PI * (5 + w % 50) * i / WINDOW_SIZE) + 0.001f * (w % 7);
+        }
+    }
+
+    VibrosonicsAPI* api = new VibrosonicsAPI();
+    api->init();
+
+    AudioLab.loadInput(input.data(), input.size());
+    std::vector<std::vector<float>> expected;
+    while (api->isAudioLabReady()) {
+        const float* spectrum = api->processAudioInput();
+        expected.emplace_back(spectrum, spectrum + WINDOW_SIZE_BY_2);
+    }
+    if ((int)expected.size() != PIPELINE_WINDOWS) {
+        fprintf(stderr, "Error: %zu of %d windows transformed\n", expected.size(), PIPELINE_WINDOWS);
+        return 1;
+    }
+
+    AudioLab.loadInput(input.data(), input.size());
+    if (!api->startPipeline()) {
+        return 1;
+    }
+
+    std::mt19937 random(1);
+    std::vector<float> previous;
+    int consumed   = 0;
+    int skipped    = 0;
+    int next       = 0;
+    int mismatches = 0;
+
+    typedef std::chrono::steady_clock Clock;
+    Clock::time_point progress = Clock::now();
+    while (consumed + (int)api->getPipelineDrops() < PIPELINE_WINDOWS) {
+        float* spectrum = api->acquireSpectrum();
+        if (!spectrum) {
+            if (Clock::now() - progress > std::chrono::seconds(PIPELINE_TIMEOUT)) {
+                fprintf(stderr, "Error: no spectrum for %d seconds\n", PIPELINE_TIMEOUT);
+                break;
+            }
+            std::this_thread::yield();
+            continue;
+        }
+        progress = Clock::now();
+
+        if (!previous.empty()) {
+            const float* history = api->getSpectrum(0);
+            if (!history || !sameSpectrum(history, previous.data())) {
+                mismatches++;
+            }
+        }
+
+        // the frame must be a later window; the windows in between were dropped
+        int window = next;
+        while (window < PIPELINE_WINDOWS && !sameSpectrum(spectrum, expected[window].data())) {
+            window++;
+        }
+        if (window == PIPELINE_WINDOWS) {
+            mismatches++;
+        } else {
+            skipped += window - next;
+            next = window + 1;
+        }
+        previous.assign(spectrum, spectrum + WINDOW_SIZE_BY_2);
+        consumed++;
+
+        // analysis of a random length, sometimes longer than a window takes
+        volatile float work = 0;
+        for (int k = (int)(random() % 20000); k > 0; k--) {
+            work = work + k;
+        }
+        api->releaseSpectrum();
+    }
+    api->stopPipeline();
+
+    uint32_t drops = api->getPipelineDrops();
+    printf("%d windows: %d consumed, %u dropped, %d mismatched\n", PIPELINE_WINDOWS, consumed, drops, mismatches);
+    delete api;
+
+    // windows dropped after the last one consumed never show up as a gap
+    skipped += PIPELINE_WINDOWS - next;
+    bool passed = mismatches == 0 && (int)drops == skipped && consumed + (int)drops == PIPELINE_WINDOWS;
+    return passed ? 0 : 1;
+}
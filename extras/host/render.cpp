@@ -0,0 +1,55 @@
+/**
+ * @file render.cpp
+ *
+ * Offline renderer: runs a Vibrosonics sketch over a WAV file on the host and
+ * writes the haptic output it synthesizes to another WAV file.
+ *
+ * The sketch is compiled into this program by defining SKETCH as its quoted
+ * path, see README.md. Its setup() runs once, then loop() runs until the host
+ * AudioLab has handed out every full window of the input, with each call to
+ * AudioLab.synthesize() appending one window of output. Serial output from
+ * the sketch goes to stdout, the render summary to stderr.
+ */
+
+#include <Arduino.h>
+#include <AudioLab.h>
+
+#ifndef SKETCH
+#error "Define SKETCH as the quoted path of the sketch to render, e.g. -DSKETCH='\"../../examples/Vibrosonics/Vibrosonics.ino\"'"
+#endif
+
+#include SKETCH
+
+int main(int argc, char** argv)
+{
+    if (argc != 3) {
+        fprintf(stderr, "usage: %s <input.wav> <output.wav>\n", argv[0]);
+        return 1;
+    }
+    if (!AudioLab.loadInput(argv[1])) {
+        return 1;
+    }
+
+    auto start = std::chrono::steady_clock::now();
+
+    setup();
+    while (!AudioLab.isFinished()) {
+        unsigned long polls = AudioLab.getNumPolls();
+        loop();
+        if (AudioLab.getNumPolls() == polls) {
+            fprintf(stderr, "Error: the sketch's loop() must check AudioLab.ready() or vapi.isAudioLabReady()\n");
+            return 1;
+        }
+    }
+
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    if (!AudioLab.writeOutput(argv[2])) {
+        return 1;
+    }
+
+    double audioSeconds = (double)AudioLab.getOutput().size() / AUD_OUT_CH / SAMPLE_RATE;
+    fprintf(stderr, "rendered %.1f s of output in %.2f s (%.0fx real time)\n", audioSeconds, seconds,
+        seconds > 0 ? audioSeconds / seconds : 0.0);
+    return 0;
+}
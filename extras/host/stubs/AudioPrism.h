@@ -0,0 +1,15 @@
+/**
+ * @file
+ * Host stand-in for the AudioPrism header. Vibrosonics itself uses nothing
+ * from AudioPrism but its Spectrogram, so this is enough for the benchmark
+ * and golden programs. Sketches that run AudioPrism analysis modules, like
+ * MajorPeaks or PercussionDetection, need the real AudioPrism on the include
+ * path ahead of this folder.
+*/
+
+#ifndef AudioPrism_h
+#define AudioPrism_h
+
+#include "Spectrogram.h"
+
+#endif
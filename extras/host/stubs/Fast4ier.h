@@ -0,0 +1,79 @@
+/**
+ * @file
+ * Host stand-in for the parts of Fast4ier used by Vibrosonics: its complex
+ * type and the in-place forward FFT. Builds with the real library on the
+ * include path use it instead.
+*/
+
+#ifndef Fast4ier_h
+#define Fast4ier_h
+
+#include <cmath>
+
+/**
+ * A complex number of two floats, as in Fast4ier.
+ */
+class complex {
+private:
+  float real;
+  float imag;
+public:
+  complex(float re = 0.0f, float im = 0.0f) : real(re), imag(im) {}
+
+  float re() const { return real; }
+  float im() const { return imag; }
+
+  complex operator+(const complex& other) const { return complex(real + other.real, imag + other.imag); }
+  complex operator-(const complex& other) const { return complex(real - other.real, imag - other.imag); }
+  complex operator*(const complex& other) const
+  {
+      return complex(real * other.real - imag * other.imag, real * other.imag + imag * other.real);
+  }
+
+  complex& operator+=(const complex& other) { return *this = *this + other; }
+  complex& operator-=(const complex& other) { return *this = *this - other; }
+  complex& operator*=(const complex& other) { return *this = *this * other; }
+};
+
+namespace Fast4 {
+
+/**
+ * Transforms n complex values in place with an iterative radix-2 FFT,
+ * computing the twiddle factors in double precision.
+ *
+ * @param data The values, replaced by their DFT.
+ * @param n The number of values, a power of two.
+ */
+inline void FFT(complex* data, int n)
+{
+    // bit reversal permutation
+    for (int i = 1, j = 0; i < n; i++) {
+        int bit = n >> 1;
+        for (; j & bit; bit >>= 1) {
+            j ^= bit;
+        }
+        j ^= bit;
+        if (i < j) {
+            complex swap = data[i];
+            data[i]      = data[j];
+            data[j]      = swap;
+        }
+    }
+
+    for (int length = 2; length <= n; length <<= 1) {
+        int half = length >> 1;
+        for (int k = 0; k < half; k++) {
+            double  angle = -2.0 * M_PI * k / length;
+            complex twiddle((float)cos(angle), (float)sin(angle));
+            for (int start = 0; start < n; start += length) {
+                complex even         = data[start + k];
+                complex odd          = data[start + k + half] * twiddle;
+                data[start + k]        = even + odd;
+                data[start + k + half] = even - odd;
+            }
+        }
+    }
+}
+
+} // namespace Fast4
+#endif
@@ -0,0 +1,41 @@
+/**
+ * @file
+ * Host stand-in for AudioPrism's Spectrogram, keeping the last few windows
+ * of a spectrum. The library only includes it; sketches that run AudioPrism
+ * modules need the real AudioPrism.
+*/
+
+#ifndef Spectrogram_h
+#define Spectrogram_h
+
+#include <cstring>
+#include <vector>
+
+#include "Config.h"
+
+/**
+ * A ring of the last numWindows spectra of WINDOW_SIZE / 2 bins.
+ */
+class Spectrogram {
+private:
+  int                numWindows;
+  int                current;
+  std::vector<float> windows;
+public:
+  Spectrogram(int numWindows = 2)
+      : numWindows(numWindows < 2 ? 2 : numWindows), current(0), windows(this->numWindows * (WINDOW_SIZE / 2))
+  {
+  }
+
+  //! Copies a spectrum in as the current window.
+  void pushWindow(const float* window)
+  {
+      current = (current + 1) % numWindows;
+      memcpy(getCurrentWindow(), window, (WINDOW_SIZE / 2) * sizeof(float));
+  }
+
+  float* getCurrentWindow() { return windows.data() + current * (WINDOW_SIZE / 2); }
+
+  float* getPreviousWindow() { return windows.data() + (current + numWindows - 1) % numWindows * (WINDOW_SIZE / 2); }
+};
+#endif
@@ -0,0 +1,187 @@
+/**
+ * @file AmplitudeNormalizer.cpp
+ *
+ * This file is part of the AmplitudeNormalizer class.
+ */
+
+#include "AmplitudeNormalizer.h"
+#include "Kernels.h"
+
+/**
+ * Creates a normalizer whose streams all follow sums like mapAmplitudes'
+ * defaults: a minimum sum of 10000, instant attack and a release of 0.05.
+ */
+AmplitudeNormalizer::AmplitudeNormalizer()
+{
+    for (int i = 0; i < AMPLITUDE_STREAMS; i++) {
+        minSum[i]     = 10000;
+        attack[i]     = 1.0f;
+        release[i]    = 0.05f;
+        configured[i] = false;
+    }
+    reset();
+}
+
+/**
+ * Sets how a stream follows its sums. The followed sum is kept, and later
+ * calls to setStreamDefaults, such as mapAmplitudes', no longer change the
+ * stream.
+ *
+ * @param stream The stream, from 0 to AMPLITUDE_STREAMS - 1.
+ * @param minSum The smallest sum to divide by.
+ * @param attack Weight of a louder sum, between 0 and 1; 1 follows it at once.
+ * @param release Weight of a quieter sum, between 0 and 1.
+ * @return false if the stream or a factor is out of range.
+ */
+bool AmplitudeNormalizer::setStream(int stream, float minSum, float attack, float release)
+{
+    if (!applyStream(stream, minSum, attack, release)) {
+        return false;
+    }
+    configured[stream] = true;
+    return true;
+}
+
+/**
+ * Sets how a stream follows its sums, like setStream, unless setStream has
+ * already configured it, in which case the stream is left as it is. This is
+ * how mapAmplitudes applies its arguments.
+ *
+ * @param stream The stream, from 0 to AMPLITUDE_STREAMS - 1.
+ * @param minSum The smallest sum to divide by.
+ * @param attack Weight of a louder sum, between 0 and 1.
+ * @param release Weight of a quieter sum, between 0 and 1.
+ * @return false if the stream or a factor is out of range.
+ */
+bool AmplitudeNormalizer::setStreamDefaults(int stream, float minSum, float attack, float release)
+{
+    if (stream >= 0 && stream < AMPLITUDE_STREAMS && configured[stream]) {
+        return true;
+    }
+    return applyStream(stream, minSum, attack, release);
+}
+
+/**
+ * Checks the arguments of setStream and stores them.
+ *
+ * @return false if the stream or a factor is out of range.
+ */
+bool AmplitudeNormalizer::applyStream(int stream, float minSum, float attack, float release)
+{
+    if (stream < 0 || stream >= AMPLITUDE_STREAMS) {
+        Serial.printf("Error: Invalid amplitude stream %d\n", stream);
+        return false;
+    }
+    if (attack < 0.0 || attack > 1.0 || release < 0.0 || release > 1.0) {
+        Serial.printf("Error: attack and release must be between 0 and 1.\n");
+        return false;
+    }
+    this->minSum[stream]  = minSum;
+    this->attack[stream]  = attack;
+    this->release[stream] = release;
+    return true;
+}
+
+/**
+ * Moves a stream's followed sum towards a new sum, by the attack factor if
+ * the new sum is larger and by the release factor otherwise, and keeps it at
+ * or above the minimum sum. A sum of 0 leaves the state as it is. Callers
+ * that already know the sum of their amplitudes can use this and divide by
+ * the result themselves instead of calling normalize.
+ *
+ * @param stream The stream, in range.
+ * @param sum The sum of the stream's amplitudes this window.
+ * @return The sum to divide the amplitudes by.
+ */
+float AmplitudeNormalizer::update(int stream, float sum)
+{
+    float followed = runningSum[stream];
+    if (sum != 0.0) {
+        // a stream that was just reset takes its first sum as it is
+        float factor = followed == 0.0f ? 1.0f : sum < followed ? release[stream] : attack[stream];
+        followed     = max(followed * (1 - factor) + sum * factor, minSum[stream]);
+        runningSum[stream] = followed;
+    }
+    return followed;
+}
+
+/**
+ * Normalizes the amplitudes of one stream in place by its followed sum.
+ * Amplitudes that sum to 0 are left as they are.
+ *
+ * @param stream The stream, from 0 to AMPLITUDE_STREAMS - 1.
+ * @param amps The amplitudes to map.
+ * @param length The number of amplitudes.
+ */
+void AmplitudeNormalizer::normalize(int stream, float* amps, int length)
+{
+    if (stream < 0 || stream >= AMPLITUDE_STREAMS) {
+        Serial.printf("Error: Invalid amplitude stream %d\n", stream);
+        return;
+    }
+    float sum = Kernels::sum(amps, length);
+    if (sum == 0.0) {
+        return;
+    }
+    Kernels::scale(amps, 1.0f / update(stream, sum), amps, length);
+}
+
+/**
+ * Normalizes several streams at once: amps[i] holds the lengths[i]
+ * amplitudes of stream i. All sums are taken first, then every stream's
+ * state is updated in one loop, and finally every stream is scaled.
+ *
+ * @param amps The amplitude array of each stream.
+ * @param lengths The number of amplitudes of each stream.
+ * @param numStreams The number of streams, at most AMPLITUDE_STREAMS.
+ */
+void AmplitudeNormalizer::normalize(float* const* amps, const int* lengths, int numStreams)
+{
+    if (numStreams < 0 || numStreams > AMPLITUDE_STREAMS) {
+        Serial.printf("Error: Invalid number of amplitude streams %d\n", numStreams);
+        return;
+    }
+
+    float scale[AMPLITUDE_STREAMS];
+    for (int i = 0; i < numStreams; i++) {
+        scale[i] = Kernels::sum(amps[i], lengths[i]);
+    }
+    for (int i = 0; i < numStreams; i++) {
+        scale[i] = scale[i] == 0.0 ? 1.0f : 1.0f / update(i, scale[i]);
+    }
+    for (int i = 0; i < numStreams; i++) {
+        Kernels::scale(amps[i], scale[i], amps[i], lengths[i]);
+    }
+}
+
+/**
+ * Returns the sum a stream last divided by, or 0 if it has not normalized
+ * anything since it was reset.
+ *
+ * @param stream The stream, in range.
+ * @return float
+ */
+float AmplitudeNormalizer::getDivisor(int stream)
+{
+    return runningSum[stream];
+}
+
+/**
+ * Clears the followed sum of a stream, so its next sum is followed at once.
+ *
+ * @param stream The stream, in range.
+ */
+void AmplitudeNormalizer::reset(int stream)
+{
+    runningSum[stream] = 0.0f;
+}
+
+/**
+ * Clears the followed sums of all streams.
+ */
+void AmplitudeNormalizer::reset()
+{
+    for (int i = 0; i < AMPLITUDE_STREAMS; i++) {
+        reset(i);
+    }
+}
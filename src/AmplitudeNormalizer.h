@@ -0,0 +1,72 @@
+/**
+ * @file
+ * Contains the declaration of the AmplitudeNormalizer class.
+*/
+
+#ifndef AmplitudeNormalizer_h
+#define AmplitudeNormalizer_h
+
+#include <AudioLab.h>
+
+#ifndef AMPLITUDE_STREAMS
+//! Number of independent streams an AmplitudeNormalizer keeps state for.
+#define AMPLITUDE_STREAMS 4
+#endif
+
+/**
+ * Maps amplitudes to the range [0, 1] by dividing them by a smoothed sum,
+ * with separate state for each of AMPLITUDE_STREAMS streams.
+ *
+ * Each stream follows the sum of the amplitudes it is given: a louder sum is
+ * followed with the attack factor and a quieter one with the release factor,
+ * and the followed sum never drops below the stream's minimum sum, which
+ * keeps quiet windows quiet. With an attack of 1 the amplitudes of a stream
+ * never sum to more than 1; a smaller attack lets onsets through louder.
+ *
+ * Streams are meant for data normalized separately, e.g. the peaks of
+ * different bands or channels, so that a loud stream does not turn the
+ * others down.
+ *
+ * A stream configured with setStream keeps its configuration until the next
+ * setStream; setStreamDefaults, which mapAmplitudes uses, leaves it alone.
+ */
+class AmplitudeNormalizer {
+private:
+  float runningSum[AMPLITUDE_STREAMS];
+  float minSum[AMPLITUDE_STREAMS];
+  float attack[AMPLITUDE_STREAMS];
+  float release[AMPLITUDE_STREAMS];
+  //! Set for streams configured with setStream
+  bool configured[AMPLITUDE_STREAMS];
+
+  //! Checks and stores the minimum sum and smoothing factors of a stream.
+  bool applyStream(int stream, float minSum, float attack, float release);
+public:
+  //! Default constructor.
+  AmplitudeNormalizer();
+
+  //! Sets the minimum sum and smoothing factors of a stream.
+  bool setStream(int stream, float minSum, float attack, float release);
+
+  //! Sets the minimum sum and smoothing factors of a stream not set with setStream.
+  bool setStreamDefaults(int stream, float minSum, float attack, float release);
+
+  //! Follows a new sum on a stream and returns the sum to divide by.
+  float update(int stream, float sum);
+
+  //! Normalizes the amplitudes of one stream.
+  void normalize(int stream, float* amps, int length);
+
+  //! Normalizes the amplitudes of streams 0 to numStreams - 1 together.
+  void normalize(float* const* amps, const int* lengths, int numStreams);
+
+  //! Returns the sum a stream last divided by.
+  float getDivisor(int stream);
+
+  //! Clears the followed sum of a stream.
+  void reset(int stream);
+
+  //! Clears the followed sums of all streams.
+  void reset();
+};
+#endif
@@ -0,0 +1,263 @@
+/**
+ * @file DeadlineMonitor.cpp
+ *
+ * This file is part of the DeadlineMonitor class.
+ */
+
+#include "DeadlineMonitor.h"
+#include <AudioLab.h>
+
+/**
+ * Creates a monitor timed by micros(), with the default policy.
+ */
+DeadlineMonitor::DeadlineMonitor()
+{
+    clock    = micros;
+    deadline = 1e6f * WINDOW_SIZE / SAMPLE_RATE;
+    decay    = 0.1f;
+    reset();
+}
+
+/**
+ * Marks the arrival of a new window and starts timing it. If more than one
+ * deadline passed since the previous window arrived, the windows in between
+ * are counted as dropped.
+ */
+void DeadlineMonitor::windowReady()
+{
+    unsigned long now = clock();
+    if (hasWindow) {
+        unsigned long missed = (unsigned long)((now - windowStart) / deadline + 0.5f);
+        if (missed > 1) {
+            numDropped += missed - 1;
+        }
+    }
+    hasWindow   = true;
+    inWindow    = true;
+    windowStart = now;
+    numWindows++;
+}
+
+/**
+ * Marks the end of processing for the current window, and updates the load
+ * and load level. Does nothing if no window is being processed, so it can be
+ * called every time the loop polls for a new window.
+ */
+void DeadlineMonitor::windowDone()
+{
+    if (!inWindow) {
+        return;
+    }
+    inWindow = false;
+
+    unsigned long processingTime = clock() - windowStart;
+    lastProcessingTime           = processingTime;
+    if (processingTime > maxProcessingTime) {
+        maxProcessingTime = processingTime;
+    }
+    if (processingTime > deadline) {
+        numOverruns++;
+    }
+
+    // rise with the first slow window, fall back over several fast ones
+    float windowLoad = processingTime / deadline;
+    if (windowLoad > load) {
+        load = windowLoad;
+    } else {
+        load += (windowLoad - load) * decay;
+    }
+
+    // a level is only left once the load is hysteresis below its threshold
+    float high     = policy.highLoad;
+    float critical = policy.criticalLoad;
+    if (level >= LOAD_HIGH) {
+        high -= policy.hysteresis;
+    }
+    if (level == LOAD_CRITICAL) {
+        critical -= policy.hysteresis;
+    }
+    if (load >= critical) {
+        level = LOAD_CRITICAL;
+    } else if (load >= high) {
+        level = LOAD_HIGH;
+    } else {
+        level = LOAD_NORMAL;
+    }
+}
+
+/**
+ * Replaces the clock used to time windows.
+ *
+ * @param clock Function returning the time in microseconds.
+ */
+void DeadlineMonitor::setClock(DeadlineClock clock)
+{
+    this->clock = clock;
+}
+
+/**
+ * Sets the load thresholds and the actions taken at each level.
+ *
+ * @param policy The DegradationPolicy to use.
+ */
+void DeadlineMonitor::setPolicy(DegradationPolicy policy)
+{
+    this->policy = policy;
+}
+
+/**
+ * Returns the degradation policy.
+ *
+ * @return DegradationPolicy
+ */
+DegradationPolicy DeadlineMonitor::getPolicy()
+{
+    return policy;
+}
+
+/**
+ * Returns the current load level.
+ *
+ * @return loadLevel
+ */
+loadLevel DeadlineMonitor::getLoadLevel()
+{
+    return level;
+}
+
+/**
+ * Returns false if the policy skips optional stages at the current level.
+ *
+ * @return bool
+ */
+bool DeadlineMonitor::allowsOptionalStages()
+{
+    return !policy.skipOptional[level];
+}
+
+/**
+ * Returns true if the policy allows another grain at the current level.
+ *
+ * @param numGrains The number of dynamic grains already running.
+ * @return bool
+ */
+bool DeadlineMonitor::allowsGrain(int numGrains)
+{
+    int maxGrains = policy.maxGrains[level];
+    return maxGrains <= 0 || numGrains < maxGrains;
+}
+
+/**
+ * Returns numRefs limited to the policy's CFAR cap at the current level.
+ *
+ * @param numRefs The number of reference cells requested.
+ * @return int
+ */
+int DeadlineMonitor::limitCFARRefs(int numRefs)
+{
+    int maxRefs = policy.maxCFARRefs[level];
+    return maxRefs > 0 && numRefs > maxRefs ? maxRefs : numRefs;
+}
+
+/**
+ * Returns the smoothed load as a fraction of the deadline.
+ *
+ * @return float
+ */
+float DeadlineMonitor::getLoad()
+{
+    return load;
+}
+
+/**
+ * Returns the window deadline in microseconds.
+ *
+ * @return float
+ */
+float DeadlineMonitor::getDeadline()
+{
+    return deadline;
+}
+
+/**
+ * Returns the processing time of the last window in microseconds.
+ *
+ * @return unsigned long
+ */
+unsigned long DeadlineMonitor::getLastProcessingTime()
+{
+    return lastProcessingTime;
+}
+
+/**
+ * Returns the longest processing time of any window since the last reset, in
+ * microseconds.
+ *
+ * @return unsigned long
+ */
+unsigned long DeadlineMonitor::getMaxProcessingTime()
+{
+    return maxProcessingTime;
+}
+
+/**
+ * Returns the number of windows processed since the last reset.
+ *
+ * @return unsigned long
+ */
+unsigned long DeadlineMonitor::getNumWindows()
+{
+    return numWindows;
+}
+
+/**
+ * Returns the number of windows that took longer than the deadline since the
+ * last reset.
+ *
+ * @return unsigned long
+ */
+unsigned long DeadlineMonitor::getNumOverruns()
+{
+    return numOverruns;
+}
+
+/**
+ * Returns the number of windows missed between arrivals since the last
+ * reset.
+ *
+ * @return unsigned long
+ */
+unsigned long DeadlineMonitor::getNumDropped()
+{
+    return numDropped;
+}
+
+/**
+ * Clears the counters, the load and the load level. The policy and clock are
+ * kept.
+ */
+void DeadlineMonitor::reset()
+{
+    level              = LOAD_NORMAL;
+    load               = 0.0f;
+    inWindow           = false;
+    hasWindow          = false;
+    windowStart        = 0;
+    lastProcessingTime = 0;
+    maxProcessingTime  = 0;
+    numWindows         = 0;
+    numOverruns        = 0;
+    numDropped         = 0;
+}
+
+/**
+ * Prints the counters, load and load level.
+ */
+void DeadlineMonitor::printStatus()
+{
+    static const char* levelNames[] = { "normal", "high", "critical" };
+    Serial.printf("windows: %lu, overruns: %lu, dropped: %lu, last: %lu us, max: %lu us "
+                  "(deadline %.0f us), load: %.2f (%s)\n",
+        numWindows, numOverruns, numDropped, lastProcessingTime, maxProcessingTime, deadline,
+        load, levelNames[level]);
+}
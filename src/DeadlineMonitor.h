@@ -0,0 +1,148 @@
+/**
+ * @file
+ * Contains the declaration of the DeadlineMonitor class.
+*/
+
+#ifndef DeadlineMonitor_h
+#define DeadlineMonitor_h
+
+#include <Arduino.h>
+
+//! Clock used to time windows, in microseconds.
+typedef unsigned long (*DeadlineClock)();
+
+/**
+ * @type loadLevel
+ *
+ * Enum for how close the window loop runs to the window deadline.
+*/
+enum loadLevel {
+  LOAD_NORMAL,   //!< Comfortably within the deadline
+  LOAD_HIGH,     //!< Close to the deadline
+  LOAD_CRITICAL  //!< At or over the deadline
+};
+
+/**
+ * @struct DegradationPolicy
+ *
+ * Struct describing when the load level changes and what VibrosonicsAPI does
+ * at each level. The per level arrays are indexed by loadLevel, and a cap of
+ * 0 means no cap. The defaults only monitor the load.
+ *
+ * @var DegradationPolicy::highLoad
+ * Load, as a fraction of the deadline, at which LOAD_HIGH is entered.
+ * @var DegradationPolicy::criticalLoad
+ * Load at which LOAD_CRITICAL is entered.
+ * @var DegradationPolicy::hysteresis
+ * How far the load must fall below a threshold to leave its level.
+ * @var DegradationPolicy::skipOptional
+ * Whether shouldRunOptionalStages returns false at each level.
+ * @var DegradationPolicy::maxGrains
+ * Dynamic grains createDynamicGrain allows in the grain list at each level.
+ * Static grains are not counted.
+ * @var DegradationPolicy::maxCFARRefs
+ * Reference cells per side noiseFloorCFAR uses at most at each level.
+ */
+struct DegradationPolicy {
+  float highLoad = 0.8;
+  float criticalLoad = 1.0;
+  float hysteresis = 0.1;
+  bool skipOptional[3] = { false, false, false };
+  int maxGrains[3] = { 0, 0, 0 };
+  int maxCFARRefs[3] = { 0, 0, 0 };
+};
+
+/**
+ * Tracks how long each window takes to process against the window deadline,
+ * WINDOW_SIZE / SAMPLE_RATE.
+ *
+ * A window's processing time runs from windowReady, when its samples arrive,
+ * to windowDone, when the loop comes back for the next window. Windows that
+ * take longer than the deadline are counted as overruns, and gaps between
+ * arrivals that span several deadlines are counted as dropped windows.
+ *
+ * The load is the processing time as a fraction of the deadline. It follows
+ * increases immediately and decays smoothly, and sets the load level from
+ * the thresholds of the DegradationPolicy. The clock can be replaced, so the
+ * monitor can be driven by a simulated clock on the host.
+ */
+class DeadlineMonitor {
+private:
+  DeadlineClock clock;
+  DegradationPolicy policy;
+  loadLevel level;
+
+  //! Window deadline in microseconds
+  float deadline;
+  //! Fraction of the way the load decays towards each new window's load
+  float decay;
+  float load;
+
+  bool inWindow;
+  bool hasWindow;
+  unsigned long windowStart;
+  unsigned long lastProcessingTime;
+  unsigned long maxProcessingTime;
+
+  unsigned long numWindows;
+  unsigned long numOverruns;
+  unsigned long numDropped;
+public:
+  //! Default constructor.
+  DeadlineMonitor();
+
+  //! Marks the arrival of a new window and starts timing it.
+  void windowReady();
+
+  //! Marks the end of processing for the current window.
+  void windowDone();
+
+  //! Replaces the clock, e.g. with a simulated one.
+  void setClock(DeadlineClock clock);
+
+  //! Sets the load thresholds and the actions taken at each level.
+  void setPolicy(DegradationPolicy policy);
+
+  //! Returns the degradation policy.
+  DegradationPolicy getPolicy();
+
+  //! Returns the current load level.
+  loadLevel getLoadLevel();
+
+  //! Returns false if the policy skips optional stages at the current level.
+  bool allowsOptionalStages();
+
+  //! Returns true if the policy allows another grain at the current level.
+  bool allowsGrain(int numGrains);
+
+  //! Returns numRefs limited to the policy's cap at the current level.
+  int limitCFARRefs(int numRefs);
+
+  //! Returns the smoothed load as a fraction of the deadline.
+  float getLoad();
+
+  //! Returns the window deadline in microseconds.
+  float getDeadline();
+
+  //! Returns the processing time of the last window in microseconds.
+  unsigned long getLastProcessingTime();
+
+  //! Returns the longest processing time of any window in microseconds.
+  unsigned long getMaxProcessingTime();
+
+  //! Returns the number of windows processed.
+  unsigned long getNumWindows();
+
+  //! Returns the number of windows that took longer than the deadline.
+  unsigned long getNumOverruns();
+
+  //! Returns the number of windows missed between arrivals.
+  unsigned long getNumDropped();
+
+  //! Clears the counters and the load.
+  void reset();
+
+  //! Prints the counters, load and load level.
+  void printStatus();
+};
+#endif
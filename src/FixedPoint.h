@@ -0,0 +1,415 @@
+/**
+ * @file
+ * Contains the declaration of the FixedPointPipeline class template and the
+ * fixed-point sample formats it supports.
+ */
+
+#ifndef FIXED_POINT_H
+#define FIXED_POINT_H
+
+#include <Arduino.h>
+#include <AudioLab.h>
+
+#include <cmath>
+#include <cstdint>
+
+#include "WindowTables.h"
+
+//! Bit depth of the ADC samples fed to the fixed-point pipeline.
+constexpr int ADC_BITS = 12;
+
+typedef int16_t q15_t; //!< Signed fixed-point value with 15 fractional bits
+typedef int32_t q31_t; //!< Signed fixed-point value with 31 fractional bits
+
+/**
+ * Describes the arithmetic of a fixed-point sample format: the number of
+ * fractional bits and the wider types used to accumulate products and sums.
+ */
+template <typename sample_t>
+struct FixedPointTraits;
+
+template <>
+struct FixedPointTraits<q15_t> {
+    typedef int32_t  acc_t;
+    typedef uint32_t uacc_t;
+    static constexpr int FRAC_BITS = 15;
+};
+
+template <>
+struct FixedPointTraits<q31_t> {
+    typedef int64_t  acc_t;
+    typedef uint64_t uacc_t;
+    static constexpr int FRAC_BITS = 31;
+};
+
+/**
+ * A table generator that converts the values of another generator, in
+ * [-1, 1], to a fixed-point sample format, rounding half away from zero and
+ * saturating at 1, so the tables of the fixed-point pipeline are generated at
+ * compile time as well.
+ */
+template <typename sample_t, typename Generator>
+struct FixedGenerator {
+    typedef typename FixedPointTraits<sample_t>::acc_t acc_t;
+
+    //! 1.0 in the sample format, one step past its largest value.
+    static constexpr double one() { return (double)((acc_t)1 << FixedPointTraits<sample_t>::FRAC_BITS); }
+
+    //! Value i of the source generator in the sample format.
+    static constexpr sample_t value(int i) { return toFixed(Generator::value(i) * one()); }
+
+    //! Rounds and saturates a value already scaled by one().
+    static constexpr sample_t toFixed(double scaled)
+    {
+        return scaled >= one() - 0.5 ? (sample_t)(one() - 1)
+            : scaled < -one()        ? (sample_t)(-one())
+            : scaled >= 0            ? (sample_t)(acc_t)(scaled + 0.5)
+                                     : (sample_t)(-(acc_t)(0.5 - scaled));
+    }
+};
+
+/**
+ * An integer-only version of the analysis front end: DC removal, hamming
+ * windowing, a real-input FFT, magnitudes and noise flooring, templated on
+ * the fixed-point sample format (q15_t or q31_t).
+ *
+ * It works directly on the ADC's integer samples. The FFT scales every stage
+ * by one half so it can never overflow, which means output magnitudes are the
+ * float path's magnitudes divided by magnitudeScale(). Use toFloat() and
+ * fromFloat() to convert magnitudes and thresholds between the two.
+ *
+ * Q15 halves the memory of Q31 and only needs 32-bit arithmetic, but each
+ * step of its output is magnitudeScale() in float units, which is coarse
+ * next to typical noise floor thresholds. Q31 is close to the float path.
+ */
+template <typename sample_t>
+class FixedPointPipeline {
+public:
+    typedef typename FixedPointTraits<sample_t>::acc_t  acc_t;
+    typedef typename FixedPointTraits<sample_t>::uacc_t uacc_t;
+
+    //! Number of fractional bits in the sample format.
+    static constexpr int FRAC_BITS = FixedPointTraits<sample_t>::FRAC_BITS;
+
+    //! Left shift applied to DC removed ADC samples, leaving one bit of
+    //! headroom so the first FFT stage cannot overflow.
+    static constexpr int INPUT_SHIFT = FRAC_BITS - ADC_BITS - 1;
+
+    //! Does nothing, the window and twiddle tables are generated at compile time.
+    void init();
+
+    //! Computes WINDOW_SIZE >> 1 frequency magnitudes from raw ADC samples.
+    void processSamples(const int* samples, sample_t* output);
+
+    //! Floors data that is below a certain threshold.
+    void noiseFloor(sample_t* data, sample_t threshold);
+
+    //! Floors input data into output using cell averaging CFAR.
+    void noiseFloorCFAR(const sample_t* input, sample_t* output, int numRefs,
+        int numGuards, float bias);
+
+    //! Returns the float path magnitude represented by one step of output.
+    static float magnitudeScale();
+
+    //! Converts an output magnitude to the float path's units.
+    static float toFloat(sample_t magnitude);
+
+    //! Converts a float path magnitude or threshold to the sample format.
+    static sample_t fromFloat(float magnitude);
+
+private:
+    static constexpr int BINS = WINDOW_SIZE >> 1;
+
+    // Tables in the sample format, constant data placed in flash
+    typedef ConstTable<sample_t, FixedGenerator<sample_t, HammingGenerator<WINDOW_SIZE>>,
+        typename MakeIndices<WINDOW_SIZE>::type> Window; //!< Hamming window
+    typedef ConstTable<sample_t, FixedGenerator<sample_t, CosGenerator<WINDOW_SIZE>>,
+        typename MakeIndices<BINS>::type> TwiddleCos; //!< cos(2 * PI * k / WINDOW_SIZE)
+    typedef ConstTable<sample_t, FixedGenerator<sample_t, SinGenerator<WINDOW_SIZE>>,
+        typename MakeIndices<BINS>::type> TwiddleSin; //!< sin(2 * PI * k / WINDOW_SIZE)
+
+    sample_t bufRe[BINS];         //!< Real part of the packed transform
+    sample_t bufIm[BINS];         //!< Imaginary part of the packed transform
+    acc_t    cfarSums[BINS + 1];  //!< Prefix sums for CFAR
+
+    //! Clamps an accumulator to the range of the sample format.
+    static sample_t saturate(acc_t value);
+
+    //! Multiplies a sample by a fractional coefficient, keeping the accumulator.
+    static acc_t mul(sample_t a, sample_t b);
+
+    //! Integer square root.
+    static uacc_t isqrt(uacc_t value);
+
+    //! Floors one edge cell of noiseFloorCFAR.
+    void noiseFloorCell(const sample_t* input, sample_t* output, int i, int numRefs,
+        int numGuards, acc_t biasQ8);
+
+    //! In place, scaled, radix-2 FFT of bufRe and bufIm.
+    void fft();
+};
+
+/**
+ * Kept for sketches that call it: the hamming window and the twiddle factors
+ * shared by the FFT and the real-input split are generated at compile time
+ * for WINDOW_SIZE, so there is nothing left to compute.
+ */
+template <typename sample_t>
+void FixedPointPipeline<sample_t>::init()
+{
+}
+
+/**
+ * Removes DC, applies the hamming window and packs sample pairs for a
+ * half-size FFT in one pass, then splits the transform into the spectrum of
+ * the real signal, writing only magnitudes to the output.
+ *
+ * @param samples WINDOW_SIZE raw ADC samples.
+ * @param output Array of WINDOW_SIZE >> 1 magnitudes, scaled by
+ * 1 / magnitudeScale() relative to the float path.
+ */
+template <typename sample_t>
+void FixedPointPipeline<sample_t>::processSamples(const int* samples, sample_t* output)
+{
+    acc_t sum = 0;
+    for (int i = 0; i < WINDOW_SIZE; i++) {
+        sum += samples[i];
+    }
+
+    // keep the mean's fraction by subtracting it after scaling the input
+    const acc_t gain = (acc_t)1 << INPUT_SHIFT;
+    acc_t       mean = sum * gain / WINDOW_SIZE;
+    const sample_t* window = Window::values;
+    for (int i = 0; i < BINS; i++) {
+        sample_t even = (sample_t)(samples[2 * i] * gain - mean);
+        sample_t odd  = (sample_t)(samples[2 * i + 1] * gain - mean);
+        bufRe[i]      = (sample_t)mul(even, window[2 * i]);
+        bufIm[i]      = (sample_t)mul(odd, window[2 * i + 1]);
+    }
+
+    fft();
+
+    // split the packed spectrum, halving it so the result stays in range
+    acc_t dc  = ((acc_t)bufRe[0] + bufIm[0]) >> 1;
+    output[0] = saturate(dc < 0 ? -dc : dc);
+    for (int k = 1; k <= BINS >> 1; k++) {
+        int   m  = BINS - k;
+        acc_t ar = bufRe[k];
+        acc_t ai = bufIm[k];
+        acc_t br = bufRe[m];
+        acc_t bi = -(acc_t)bufIm[m];
+
+        sample_t evenRe = saturate((ar + br) >> 1);
+        sample_t evenIm = saturate((ai + bi) >> 1);
+        sample_t oddRe  = saturate((ai - bi) >> 1);
+        sample_t oddIm  = saturate((br - ar) >> 1);
+
+        sample_t c     = TwiddleCos::values[k];
+        sample_t s     = TwiddleSin::values[k];
+        acc_t    rotRe = mul(oddRe, c) + mul(oddIm, s);
+        acc_t    rotIm = mul(oddIm, c) - mul(oddRe, s);
+
+        acc_t loRe = (evenRe + rotRe) >> 1;
+        acc_t loIm = (evenIm + rotIm) >> 1;
+        acc_t hiRe = (evenRe - rotRe) >> 1;
+        acc_t hiIm = (rotIm - evenIm) >> 1;
+        output[m]  = saturate(isqrt((uacc_t)(hiRe * hiRe) + (uacc_t)(hiIm * hiIm)));
+        output[k]  = saturate(isqrt((uacc_t)(loRe * loRe) + (uacc_t)(loIm * loIm)));
+    }
+}
+
+/**
+ * Sets the amplitude of a bin to 0 if it is less than threshold.
+ *
+ * @param data The frequency domain data to filter.
+ * @param threshold The threshold value to floor the data at, see fromFloat().
+ */
+template <typename sample_t>
+void FixedPointPipeline<sample_t>::noiseFloor(sample_t* data, sample_t threshold)
+{
+    for (int i = 0; i < BINS; i++) {
+        if (data[i] < threshold) {
+            data[i] = 0;
+        }
+    }
+}
+
+/**
+ * Cell averaging CFAR over prefix sums, matching
+ * VibrosonicsAPI::noiseFloorCFAR with CA_CFAR. Input and output may be the
+ * same array.
+ *
+ * @param input The frequency domain data to filter.
+ * @param output The array to write the filtered data to.
+ * @param numRefs The number of reference cells on each side of the CUT.
+ * @param numGuards The number of guard cells for CFAR.
+ * @param bias The bias factor to use for CFAR, resolved to 1/256.
+ */
+template <typename sample_t>
+void FixedPointPipeline<sample_t>::noiseFloorCFAR(const sample_t* input, sample_t* output,
+    int numRefs, int numGuards, float bias)
+{
+    acc_t biasQ8 = (acc_t)(bias * 256.0f + 0.5f);
+
+    cfarSums[0] = 0;
+    for (int i = 0; i < BINS; i++) {
+        cfarSums[i + 1] = cfarSums[i] + input[i];
+    }
+
+    // cells whose reference windows lie fully inside the spectrum need no
+    // clamping, only the numGuards + numRefs cells at either edge do
+    int edge     = numRefs > 0 ? min(BINS, numGuards + numRefs) : BINS;
+    int interior = max(edge, BINS - edge);
+
+    for (int i = 0; i < edge; i++) {
+        noiseFloorCell(input, output, i, numRefs, numGuards, biasQ8);
+    }
+
+    const acc_t numCells = 2 * numRefs;
+    for (int i = edge; i < interior; i++) {
+        acc_t noiseSum = (cfarSums[i - numGuards] - cfarSums[i - numGuards - numRefs])
+            + (cfarSums[i + numGuards + numRefs] - cfarSums[i + numGuards]);
+        acc_t noiseLevel = noiseSum / numCells;
+
+        sample_t cut = input[i];
+        output[i]    = (acc_t)cut * 256 > noiseLevel * biasQ8 ? cut : 0;
+    }
+
+    for (int i = interior; i < BINS; i++) {
+        noiseFloorCell(input, output, i, numRefs, numGuards, biasQ8);
+    }
+}
+
+/**
+ * Floors one cell of noiseFloorCFAR, clamping its reference windows to the
+ * spectrum. Reads the prefix sums noiseFloorCFAR computed.
+ */
+template <typename sample_t>
+void FixedPointPipeline<sample_t>::noiseFloorCell(const sample_t* input, sample_t* output, int i,
+    int numRefs, int numGuards, acc_t biasQ8)
+{
+    int left_start  = max(0, i - numGuards - numRefs);
+    int left_end    = max(0, i - numGuards);
+    int right_start = min(BINS, i + numGuards);
+    int right_end   = min(BINS, i + numGuards + numRefs);
+
+    int   numCells = (left_end - left_start) + (right_end - right_start);
+    acc_t noiseSum = (cfarSums[left_end] - cfarSums[left_start])
+        + (cfarSums[right_end] - cfarSums[right_start]);
+    acc_t noiseLevel = noiseSum / (numCells > 0 ? numCells : 1);
+
+    sample_t cut = input[i];
+    output[i]    = (acc_t)cut * 256 > noiseLevel * biasQ8 ? cut : 0;
+}
+
+/**
+ * Returns the float path magnitude represented by one step of output: the
+ * FFT and split scale by 1 / WINDOW_SIZE, and the input by 2^INPUT_SHIFT.
+ */
+template <typename sample_t>
+float FixedPointPipeline<sample_t>::magnitudeScale()
+{
+    return (float)WINDOW_SIZE / (float)((acc_t)1 << INPUT_SHIFT);
+}
+
+/**
+ * Converts an output magnitude to the float path's units.
+ *
+ * @param magnitude A magnitude from processSamples.
+ */
+template <typename sample_t>
+float FixedPointPipeline<sample_t>::toFloat(sample_t magnitude)
+{
+    return magnitude * magnitudeScale();
+}
+
+/**
+ * Converts a float path magnitude or threshold to the sample format.
+ *
+ * @param magnitude A magnitude in the float path's units.
+ */
+template <typename sample_t>
+sample_t FixedPointPipeline<sample_t>::fromFloat(float magnitude)
+{
+    return saturate((acc_t)(magnitude / magnitudeScale() + 0.5f));
+}
+
+template <typename sample_t>
+sample_t FixedPointPipeline<sample_t>::saturate(acc_t value)
+{
+    const acc_t hi = ((acc_t)1 << FRAC_BITS) - 1;
+    const acc_t lo = -((acc_t)1 << FRAC_BITS);
+    return (sample_t)(value > hi ? hi : (value < lo ? lo : value));
+}
+
+template <typename sample_t>
+typename FixedPointPipeline<sample_t>::acc_t FixedPointPipeline<sample_t>::mul(sample_t a, sample_t b)
+{
+    return ((acc_t)a * b) >> FRAC_BITS;
+}
+
+template <typename sample_t>
+typename FixedPointPipeline<sample_t>::uacc_t FixedPointPipeline<sample_t>::isqrt(uacc_t value)
+{
+    uacc_t result = 0;
+    uacc_t bit    = (uacc_t)1 << (sizeof(uacc_t) * 8 - 2);
+    while (bit > value) {
+        bit >>= 2;
+    }
+    while (bit != 0) {
+        if (value >= result + bit) {
+            value -= result + bit;
+            result = (result >> 1) + bit;
+        } else {
+            result >>= 1;
+        }
+        bit >>= 2;
+    }
+    return result;
+}
+
+/**
+ * Decimation in time FFT of BINS points. Each stage halves its butterflies,
+ * so the output is the transform divided by BINS and never overflows.
+ */
+template <typename sample_t>
+void FixedPointPipeline<sample_t>::fft()
+{
+    // bit reversal permutation, from the table generated for WINDOW_SIZE
+    const uint16_t* reversed = WindowTables<WINDOW_SIZE>::bitReverse();
+    for (int i = 1; i < BINS; i++) {
+        int j = reversed[i];
+        if (i < j) {
+            sample_t re = bufRe[i];
+            sample_t im = bufIm[i];
+            bufRe[i]    = bufRe[j];
+            bufIm[i]    = bufIm[j];
+            bufRe[j]    = re;
+            bufIm[j]    = im;
+        }
+    }
+
+    for (int size = 2; size <= BINS; size <<= 1) {
+        int half   = size >> 1;
+        int stride = WINDOW_SIZE / size;
+        for (int start = 0; start < BINS; start += size) {
+            for (int j = 0; j < half; j++) {
+                int      a  = start + j;
+                int      b  = a + half;
+                sample_t c  = TwiddleCos::values[j * stride];
+                sample_t s  = TwiddleSin::values[j * stride];
+                acc_t    tr = mul(bufRe[b], c) + mul(bufIm[b], s);
+                acc_t    ti = mul(bufIm[b], c) - mul(bufRe[b], s);
+
+                acc_t re = bufRe[a];
+                acc_t im = bufIm[a];
+                bufRe[a] = saturate((re + tr) >> 1);
+                bufIm[a] = saturate((im + ti) >> 1);
+                bufRe[b] = saturate((re - tr) >> 1);
+                bufIm[b] = saturate((im - ti) >> 1);
+            }
+        }
+    }
+}
+
+#endif // FIXED_POINT_H
@@ -6,6 +6,7 @@
 
 #include "Grain.h"
 #include <math.h>
+#include <new>
 
 /**
  * Creates a grain on channel 0 and sine wave type in
@@ -50,7 +51,7 @@ void Grain::setAttack(float frequency, float amplitude, int duration)
 {
     attack.frequency = frequency;
     attack.amplitude = amplitude;
-    attack.duration  = duration;
+    shapePhase(attack, duration, attack.curve);
 }
 
 /**
@@ -64,7 +65,7 @@ void Grain::setDecay(float frequency, float amplitude, int duration)
 {
     decay.frequency = frequency;
     decay.amplitude = amplitude;
-    decay.duration  = duration;
+    shapePhase(decay, duration, decay.curve);
 }
 
 /**
@@ -94,7 +95,7 @@ void Grain::setRelease(float frequency, float amplitude, int duration)
 {
     release.frequency = frequency;
     release.amplitude = amplitude;
-    release.duration  = duration;
+    shapePhase(release, duration, release.curve);
 }
 
 /**
@@ -122,8 +123,11 @@ void Grain::setWaveType(WaveType waveType)
  * Switches grain states based on the window counter and durations for
  * each state. In essence it progresses the sample along the attack sustain
  * release curve.
+ *
+ * @param batch The WaveBatch to add the grain's wave to, or nullptr to
+ * create it with AudioLab directly.
  */
-void Grain::run()
+void Grain::run(WaveBatch* batch)
 {
     switch (state) {
     case READY:
@@ -131,12 +135,7 @@ void Grain::run()
 
     case ATTACK:
         if (windowCounter < attack.duration) {
-            float pos            = (float)(windowCounter + 1) / (float)attack.duration;
-            float curvedProgress = powf(pos, attack.curve);
-            // Compute and update frequncy and amplitude with incremental curve position
-            grainFrequency = attack.frequency * curvedProgress;
-            grainAmplitude = attack.amplitude * curvedProgress;
-
+            updateEnvelope();
         } else {
             transitionTo(DECAY);
         }
@@ -144,10 +143,7 @@ void Grain::run()
 
     case DECAY:
         if (windowCounter < decay.duration) {
-            float pos            = (float)(windowCounter + 1) / (float)decay.duration;
-            float curvedProgress = powf(pos, decay.curve);
-            grainFrequency       = decay.frequency + (sustain.frequency - attack.frequency) * curvedProgress;
-            grainAmplitude       = decay.amplitude + (sustain.amplitude - attack.amplitude) * curvedProgress;
+            updateEnvelope();
         } else {
             transitionTo(SUSTAIN);
         }
@@ -161,11 +157,7 @@ void Grain::run()
 
     case RELEASE:
         if (windowCounter < release.duration) {
-            float pos            = (float)(windowCounter + 1) / (float)release.duration;
-            float curvedProgress = powf(pos, release.curve);
-            // Compute and update frequncy and amplitude with incremental curve position
-            grainFrequency = sustain.frequency + (release.frequency - sustain.frequency) * curvedProgress;
-            grainAmplitude = sustain.amplitude + (release.amplitude - sustain.amplitude) * curvedProgress;
+            updateEnvelope();
         } else {
             transitionTo(READY);
         }
@@ -179,7 +171,11 @@ void Grain::run()
 
     // Create a wave if grain is active
     if (state != READY) {
-        AudioLab.dynamicWave(grainChannel, grainFrequency, grainAmplitude, 0.0, waveType);
+        if (batch != nullptr) {
+            batch->add(grainChannel, grainFrequency, grainAmplitude, 0.0, waveType);
+        } else {
+            AudioLab.dynamicWave(grainChannel, grainFrequency, grainAmplitude, 0.0, waveType);
+        }
         windowCounter++;
     }
     // this->printGrain();
@@ -188,7 +184,6 @@ void Grain::run()
 /**
  * Helper function for run. Handles skipped states and prepares Grain
  * for the current window without leaving a 1 window gap between grain states.
- * NOTE: To future teams, you may want to refactor run to be a do while loop like what transition to does. Lots of repeated code.
  *
  * @param newState State to transition to.
  */
@@ -205,50 +200,29 @@ void Grain::transitionTo(grainState newState)
             if (isDynamic) {
                 markedForDeletion = true;
             }
-            grainFrequency = 0.0f;
-            grainAmplitude = 0.0f;
             break;
         case ATTACK:
             if (attack.duration <= 0) {
                 state        = DECAY;
                 stateSkipped = true;
-            } else {
-                float pos            = (float)(windowCounter + 1) / (float)attack.duration;
-                float curvedProgress = powf(pos, attack.curve);
-                grainFrequency       = attack.frequency * curvedProgress;
-                grainAmplitude       = attack.amplitude * curvedProgress;
             }
             break;
         case DECAY:
             if (decay.duration <= 0) {
                 state        = SUSTAIN;
                 stateSkipped = true;
-            } else {
-                float pos            = (float)(windowCounter + 1) / (float)decay.duration;
-                float curvedProgress = powf(pos, decay.curve);
-                grainFrequency       = decay.frequency + (sustain.frequency - attack.frequency) * curvedProgress;
-                grainAmplitude       = decay.amplitude + (sustain.amplitude - attack.amplitude) * curvedProgress;
             }
             break;
         case SUSTAIN:
             if (sustain.duration <= 0) {
                 state        = RELEASE;
                 stateSkipped = true;
-            } else {
-                grainFrequency = sustain.frequency;
-                grainAmplitude = sustain.amplitude;
             }
             break;
         case RELEASE:
             if (release.duration <= 0) {
                 state        = READY;
                 stateSkipped = true;
-            } else {
-                float pos            = (float)(windowCounter + 1) / (float)release.duration;
-                float curvedProgress = powf(pos, release.curve);
-                // Compute and update frequncy and amplitude with incremental curve position
-                grainFrequency = sustain.frequency + (release.frequency - sustain.frequency) * curvedProgress;
-                grainAmplitude = sustain.amplitude + (release.amplitude - sustain.amplitude) * curvedProgress;
             }
             break;
         default:
@@ -256,6 +230,73 @@ void Grain::transitionTo(grainState newState)
             break;
         }
     } while (stateSkipped);
+
+    updateEnvelope();
+}
+
+/**
+ * Sets the duration and curve of a phase, and looks up the shared curve
+ * table for the pair so the phase never has to call powf.
+ *
+ * @param phase The phase to shape
+ * @param duration Number of windows the phase runs for
+ * @param curve Shape of the progression through the phase
+ */
+void Grain::shapePhase(Phase& phase, int duration, float curve)
+{
+    phase.duration = duration;
+    phase.curve    = curve;
+    phase.table    = EnvelopeCurveCache::get(duration, curve);
+}
+
+/**
+ * Returns the curved progress through a phase for the current window. This
+ * is a table read for cached curves, and a division for linear ones.
+ *
+ * @param phase The current phase, with windowCounter < phase.duration
+ * @return float
+ */
+float Grain::curvedProgress(const Phase& phase)
+{
+    if (phase.table) {
+        return phase.table[windowCounter];
+    }
+    float pos = (float)(windowCounter + 1) / (float)phase.duration;
+    return phase.curve == 1.0f ? pos : powf(pos, phase.curve);
+}
+
+/**
+ * Computes and updates frequency and amplitude with the incremental curve
+ * position of the current state.
+ */
+void Grain::updateEnvelope()
+{
+    float progress;
+    switch (state) {
+    case ATTACK:
+        progress       = curvedProgress(attack);
+        grainFrequency = attack.frequency * progress;
+        grainAmplitude = attack.amplitude * progress;
+        break;
+    case DECAY:
+        progress       = curvedProgress(decay);
+        grainFrequency = decay.frequency + (sustain.frequency - attack.frequency) * progress;
+        grainAmplitude = decay.amplitude + (sustain.amplitude - attack.amplitude) * progress;
+        break;
+    case SUSTAIN:
+        grainFrequency = sustain.frequency;
+        grainAmplitude = sustain.amplitude;
+        break;
+    case RELEASE:
+        progress       = curvedProgress(release);
+        grainFrequency = sustain.frequency + (release.frequency - sustain.frequency) * progress;
+        grainAmplitude = sustain.amplitude + (release.amplitude - sustain.amplitude) * progress;
+        break;
+    default:
+        grainFrequency = 0.0f;
+        grainAmplitude = 0.0f;
+        break;
+    }
 }
 
 /**
@@ -361,13 +402,10 @@ void Grain::setAmpEnv(AmpEnv ampEnv)
  */
 void Grain::setDurEnv(DurEnv durEnv)
 {
-  attack.duration = durEnv.attackDuration;
-  attack.curve = durEnv.curve;
-  decay.duration = durEnv.decayDuration;
-  decay.curve = durEnv.curve;
+  shapePhase(attack, durEnv.attackDuration, durEnv.curve);
+  shapePhase(decay, durEnv.decayDuration, durEnv.curve);
   sustain.duration = durEnv.sustainDuration;
-  release.duration = durEnv.releaseDuration;
-  release.curve = durEnv.curve;
+  shapePhase(release, durEnv.releaseDuration, durEnv.curve);
 }
 
 /**
@@ -378,67 +416,252 @@ void Grain::printGrain()
     Serial.printf("State: %i, Frequency: %f, Amplitude: %f\n", state, grainFrequency, grainAmplitude);
 }
 
+EnvelopeCurveCache::Entry EnvelopeCurveCache::entries[CURVE_CACHE_ENTRIES];
+int   EnvelopeCurveCache::numEntries = 0;
+float EnvelopeCurveCache::values[CURVE_CACHE_VALUES];
+int   EnvelopeCurveCache::numValues = 0;
+
 /**
- * Pushes a grain to the tail of the GrainList.
+ * Returns the table of powf((k + 1) / duration, curve) for k in
+ * [0, duration), building it the first time a pair is requested.
  *
- * @param grain the grain to be pushed
+ * @param duration Number of windows in the phase
+ * @param curve Shape of the progression through the phase
+ * @return const float*, or nullptr for linear curves, empty phases, or when
+ * the cache is full
+ */
+const float* EnvelopeCurveCache::get(int duration, float curve)
+{
+    if (curve == 1.0f || duration <= 0) {
+        return nullptr;
+    }
+
+    for (int i = 0; i < numEntries; i++) {
+        if (entries[i].duration == duration && entries[i].curve == curve) {
+            return entries[i].table;
+        }
+    }
+
+    if (numEntries == CURVE_CACHE_ENTRIES || numValues + duration > CURVE_CACHE_VALUES) {
+        return nullptr;
+    }
+
+    float* table = &values[numValues];
+    for (int k = 0; k < duration; k++) {
+        table[k] = powf((float)(k + 1) / (float)duration, curve);
+    }
+    numValues += duration;
+    entries[numEntries++] = { duration, curve, table };
+    return table;
+}
+
+/**
+ * Returns the bytes of RAM of the cache: its entries and the values of the
+ * tables they point to.
+ *
+ * @return size_t
  */
-void GrainList::pushGrain(Grain* grain)
+size_t EnvelopeCurveCache::tableMemory()
 {
-    GrainNode* newGrain = new GrainNode(grain);
+    return sizeof(entries) + sizeof(values);
+}
+
+/**
+ * Creates an empty GrainList with every slot of the slab on the free list.
+ */
+GrainList::GrainList()
+{
+    head        = nullptr;
+    tail        = nullptr;
+    numGrains        = 0;
+    numDynamicGrains = 0;
+    stealPolicy      = STEAL_OLDEST;
+    for (int i = 0; i < GRAIN_POOL_SIZE - 1; i++) {
+        nodes[i].next = &nodes[i + 1];
+    }
+    nodes[GRAIN_POOL_SIZE - 1].next = nullptr;
+    freeNodes                       = &nodes[0];
+}
+
+/**
+ * Takes a node from the free list. If there is none, a node is stolen from a
+ * dynamic grain according to the steal policy, and unlinked from the list.
+ *
+ * @return GrainNode*, or nullptr if no node is available
+ */
+GrainNode* GrainList::acquireNode()
+{
+    if (freeNodes) {
+        GrainNode* node = freeNodes;
+        freeNodes       = node->next;
+        node->next      = nullptr;
+        return node;
+    }
+
+    if (stealPolicy == STEAL_NONE) {
+        return nullptr;
+    }
+
+    // the list is in creation order, so the first dynamic grain is the oldest
+    GrainNode* victim     = nullptr;
+    GrainNode* victimPrev = nullptr;
+    GrainNode* prev       = nullptr;
+    for (GrainNode* current = head; current != nullptr; current = current->next) {
+        if (current->reference->isDynamic) {
+            if (!victim || (stealPolicy == STEAL_QUIETEST && current->reference->getAmplitude() < victim->reference->getAmplitude())) {
+                victim     = current;
+                victimPrev = prev;
+            }
+            if (stealPolicy == STEAL_OLDEST) {
+                break;
+            }
+        }
+        prev = current;
+    }
+
+    if (victim) {
+        unlinkNode(victim, victimPrev);
+        numDynamicGrains--;
+    }
+    return victim;
+}
+
+/**
+ * Unlinks a node from the list.
+ *
+ * @param node The node to unlink
+ * @param prev The node before it, or nullptr if it is the head
+ */
+void GrainList::unlinkNode(GrainNode* node, GrainNode* prev)
+{
+    if (prev == nullptr) {
+        head = node->next;
+    } else {
+        prev->next = node->next;
+    }
+    if (node->next == nullptr) {
+        tail = prev;
+    }
+    node->next = nullptr;
+    numGrains--;
+}
+
+/**
+ * Links a node to the tail of the list.
+ *
+ * @param node The node to link
+ */
+void GrainList::linkNode(GrainNode* node)
+{
+    node->next = nullptr;
     if (!head) {
-        head = tail = newGrain;
+        head = tail = node;
     } else {
-        tail->next = newGrain;
-        tail       = newGrain;
+        tail->next = node;
+        tail       = node;
+    }
+    numGrains++;
+}
+
+/**
+ * Returns a node that is no longer linked. Nodes of the slab go back on the
+ * free list; a static grain's own node is freed.
+ *
+ * @param node The node to release
+ */
+void GrainList::releaseNode(GrainNode* node)
+{
+    node->reference = nullptr;
+    if (node >= nodes && node < nodes + GRAIN_POOL_SIZE) {
+        node->next = freeNodes;
+        freeNodes  = node;
+        numDynamicGrains--;
+    } else {
+        delete node;
+    }
+}
+
+/**
+ * Pushes a grain owned by the caller to the tail of the GrainList. The grain
+ * is linked through a node of its own rather than a slot of the slab, which
+ * is only for dynamic grains, so static grains are pushed once, e.g. when
+ * they are created in setup, and never steal from dynamic grains.
+ *
+ * @param grain the grain to be pushed
+ * @return true if the grain was pushed, false if its node could not be
+ * allocated
+ */
+bool GrainList::pushGrain(Grain* grain)
+{
+    GrainNode* node = new (std::nothrow) GrainNode(grain);
+    if (!node) {
+        Serial.printf("Error: out of memory for a static grain\n");
+        return false;
+    }
+    linkNode(node);
+    return true;
+}
+
+/**
+ * Creates a dynamic grain in a slot of the slab and pushes it to the tail of
+ * the GrainList. The grain is reaped once it finishes its envelope, or when
+ * it is stolen to make room for a newer grain.
+ *
+ * @return Grain*, or nullptr if the slab is full and nothing could be stolen
+ */
+Grain* GrainList::allocateGrain()
+{
+    GrainNode* node = acquireNode();
+    if (!node) {
+        return nullptr;
     }
+    Grain* grain     = &grains[node - nodes];
+    *grain           = Grain();
+    grain->isDynamic = true;
+    node->reference  = grain;
+    linkNode(node);
+    numDynamicGrains++;
+    return grain;
 }
 
 /**
- * Deletes all grains in the GrainList.
+ * Removes all grains from the GrainList, returning the dynamic grains' slots
+ * to the slab. Static grains stay owned by the caller.
  */
 void GrainList::clearList()
 {
     GrainNode* current = head;
     while (current) {
         GrainNode* next = current->next;
-        delete current->reference;
-        delete current;
+        releaseNode(current);
         current = next;
     }
     head = tail = nullptr;
+    numGrains   = 0;
 }
 
 /**
- * Runs update on all grains in the list. Deletes dynamic grains if they have
- * finished their lifespan and are ready to be "reaped".
+ * Runs update on all grains in the list. Returns the nodes of dynamic grains
+ * that have finished their lifespan and are ready to be "reaped" to the slab.
+ *
+ * @param batch The WaveBatch to add the grains' waves to, or nullptr to
+ * create them with AudioLab directly.
  */
-void GrainList::updateAndReap()
+void GrainList::updateAndReap(WaveBatch* batch)
 {
     GrainNode* current = head;
     GrainNode* prev    = nullptr;
 
     while (current != nullptr) {
         GrainNode* nextNode = current->next;
-        current->reference->run();
+        current->reference->run(batch);
         if (current->reference->isDynamic && current->reference->markedForDeletion && current->reference->getGrainState() == READY) {
-            if (prev == nullptr) {
-                head = nextNode;
-            } else {
-                prev->next = nextNode;
-            }
-            if (nextNode == nullptr) {
-                tail = prev;
-            }
-
-            delete current->reference;
-            delete current;
-
-            current = nextNode;
+            unlinkNode(current, prev);
+            releaseNode(current);
         } else {
-            prev    = current;
-            current = nextNode;
+            prev = current;
         }
+        current = nextNode;
     }
 }
 
@@ -451,3 +674,35 @@ GrainNode* GrainList::getHead()
 {
     return head;
 }
+
+/**
+ * Returns the number of grains in the GrainList, static and dynamic.
+ *
+ * @return int
+ */
+int GrainList::getNumGrains()
+{
+    return numGrains;
+}
+
+/**
+ * Returns the number of dynamic grains in the GrainList, that is the slots
+ * of the slab in use. Static grains are not counted.
+ *
+ * @return int
+ */
+int GrainList::getNumDynamicGrains()
+{
+    return numDynamicGrains;
+}
+
+/**
+ * Sets how to make room for a new dynamic grain when all GRAIN_POOL_SIZE
+ * slots are in use.
+ *
+ * @param policy The grainStealPolicy to use
+ */
+void GrainList::setStealPolicy(grainStealPolicy policy)
+{
+    stealPolicy = policy;
+}
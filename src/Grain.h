@@ -8,6 +8,8 @@
 
 #include <AudioLab.h>
 
+#include "WaveBatch.h"
+
 /**
  * @type grainState
  *
@@ -93,6 +95,56 @@ struct DurEnv {
   float curve = 1.0f;
 };
 
+#ifndef CURVE_CACHE_VALUES
+//! Number of values shared by all cached envelope curve tables, a quarter
+//! as many with VIBROSONICS_LOW_MEMORY.
+#ifdef VIBROSONICS_LOW_MEMORY
+#define CURVE_CACHE_VALUES 64
+#else
+#define CURVE_CACHE_VALUES 256
+#endif
+#endif
+
+#ifndef CURVE_CACHE_ENTRIES
+//! Number of (duration, curve) pairs the envelope curve cache can hold.
+#ifdef VIBROSONICS_LOW_MEMORY
+#define CURVE_CACHE_ENTRIES 4
+#else
+#define CURVE_CACHE_ENTRIES 16
+#endif
+#endif
+
+/**
+ * Cache of envelope curve lookup tables shared by every grain.
+ *
+ * A grain's progress through a phase lasting duration windows is
+ * powf((windowCounter + 1) / duration, curve). Rather than evaluating that
+ * every window, the values for each (duration, curve) pair are computed once
+ * into a table which is then shared by all grains using that pair. Tables are
+ * stored in a fixed buffer and never evicted; once it is full, grains with
+ * new pairs fall back to powf.
+ */
+class EnvelopeCurveCache {
+private:
+  struct Entry {
+    int duration;
+    float curve;
+    const float *table;
+  };
+
+  static Entry entries[CURVE_CACHE_ENTRIES];
+  static int numEntries;
+  static float values[CURVE_CACHE_VALUES];
+  static int numValues;
+public:
+  //! Returns the table for a (duration, curve) pair, or nullptr if none is
+  //! needed or the cache is full.
+  static const float* get(int duration, float curve);
+
+  //! Returns the bytes of RAM of the cache.
+  static size_t tableMemory();
+};
+
 class GrainList;
 
 /**
@@ -120,6 +172,8 @@ private:
     float amplitude = 0.0f;
     //! Shapes the curve by raising curveStep*windowCounter to the degree of the curve value
     float curve = 1.0f; // Default: linear
+    //! Curved progress for each window of the phase, nullptr if linear
+    const float *table = nullptr;
   };
 
   //! Struct containing attack parameters
@@ -149,7 +203,16 @@ private:
   grainState state;
 
   //! Update frequency and amplitude values based on current grain state.
-  void run();
+  void run(WaveBatch* batch = nullptr);
+
+  //! Sets the duration and curve of a phase, looking up its curve table.
+  static void shapePhase(Phase &phase, int duration, float curve);
+
+  //! Returns the curved progress through a phase for the current window.
+  float curvedProgress(const Phase &phase);
+
+  //! Sets frequency and amplitude for the current window of the current state.
+  void updateEnvelope();
 public:
   //! Flag to check if a grain is dynamic or static.
   bool isDynamic;
@@ -230,11 +293,35 @@ public:
   friend class GrainList;
 };
 
+#ifndef GRAIN_POOL_SIZE
+//! Maximum number of dynamic grains a GrainList holds at once, 8 with
+//! VIBROSONICS_LOW_MEMORY. Static grains are not counted.
+#ifdef VIBROSONICS_LOW_MEMORY
+#define GRAIN_POOL_SIZE 8
+#else
+#define GRAIN_POOL_SIZE 32
+#endif
+#endif
+
+/**
+ * @type grainStealPolicy
+ *
+ * Enum for choosing which dynamic grain a full GrainList gives up to make
+ * room for a new one. Static grains are never stolen.
+*/
+enum grainStealPolicy {
+  STEAL_OLDEST,   //!< Reuse the dynamic grain that was created first
+  STEAL_QUIETEST, //!< Reuse the dynamic grain with the lowest amplitude
+  STEAL_NONE      //!< Drop the new grain instead
+};
+
 /**
  * Struct for a node in the Grain List
  */
 struct GrainNode {
   //! Default constructor.
+  GrainNode() : reference(nullptr), next(nullptr) {}
+  //! Constructor for a node referencing a grain.
   GrainNode(Grain *object) : reference(object), next(nullptr) {}
   //! Reference containing grain data
   Grain *reference;
@@ -243,7 +330,14 @@ struct GrainNode {
 };
 
 /**
- * Class for the management of a linked list of grains
+ * Class for the management of a linked list of grains.
+ *
+ * Dynamic grains and their nodes come from a fixed slab of GRAIN_POOL_SIZE
+ * slots with a free list, so creating and reaping them never touches the
+ * heap. When the slab is full, new dynamic grains steal a slot according to
+ * the grainStealPolicy. Static grains are owned by the caller and linked
+ * through a node of their own, allocated once when they are pushed, so they
+ * take no slot and there is no limit on how many there are.
  */
 class GrainList {
 private:
@@ -251,16 +345,45 @@ private:
   GrainNode *head;
   //! Grain at the back of the list
   GrainNode *tail;
+  //! First unused node of the slab
+  GrainNode *freeNodes;
+  //! Number of grains in the list
+  int numGrains;
+  //! Number of slots of the slab in use by dynamic grains
+  int numDynamicGrains;
+  //! Contiguous slab the dynamic grains' nodes come from
+  GrainNode nodes[GRAIN_POOL_SIZE];
+  //! Storage of the dynamic grains, one per node of the slab
+  Grain grains[GRAIN_POOL_SIZE];
+  //! How to make room for a dynamic grain when the slab is full
+  grainStealPolicy stealPolicy;
+
+  //! Takes a node from the free list, or steals one from a dynamic grain.
+  GrainNode* acquireNode();
+  //! Unlinks a node from the list, given the node before it.
+  void unlinkNode(GrainNode *node, GrainNode *prev);
+  //! Links a node to the tail of the list.
+  void linkNode(GrainNode *node);
+  //! Returns an unlinked node to the slab, or frees a static grain's node.
+  void releaseNode(GrainNode *node);
 public:
   //! Default constructor.
-  GrainList() : head(nullptr), tail(nullptr) {}
+  GrainList();
   //! Pushes a grain to the tail of the list.
-  void pushGrain(Grain *grain);
-  //! Deletes all grains in the list.
+  bool pushGrain(Grain *grain);
+  //! Creates a dynamic grain owned by the list, and pushes it to the tail.
+  Grain* allocateGrain();
+  //! Removes all grains from the list.
   void clearList();
   //! Returns the head of the list.
   GrainNode* getHead();
-  //! Updates grains and deletes finished dynamic grains.
-  void updateAndReap();
+  //! Returns the number of grains in the list.
+  int getNumGrains();
+  //! Returns the number of dynamic grains in the list.
+  int getNumDynamicGrains();
+  //! Updates grains and reaps finished dynamic grains.
+  void updateAndReap(WaveBatch* batch = nullptr);
+  //! Sets how to make room for a dynamic grain when the list is full.
+  void setStealPolicy(grainStealPolicy policy);
 };
 #endif
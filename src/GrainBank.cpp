@@ -0,0 +1,309 @@
+/**
+ * @file GrainBank.cpp
+ *
+ * This file is part of the GrainBank class.
+ */
+
+#include "GrainBank.h"
+#include <math.h>
+
+/**
+ * Creates an empty bank.
+ */
+GrainBank::GrainBank()
+{
+    numActive    = 0;
+    numCurved    = 0;
+    triggerCount = 0;
+    stealPolicy  = STEAL_OLDEST;
+}
+
+/**
+ * Triggers a new grain in the ATTACK state, like a dynamic Grain created by
+ * VibrosonicsAPI::createDynamicGrain.
+ *
+ * @param channel Specified channel for output
+ * @param waveType Specified wave type for output
+ * @param freqEnv The frequency data used to shape the grain.
+ * @param ampEnv The amplitude data used to shape the grain.
+ * @param durEnv The duration lengths and curve to shape the grain.
+ * @return The slot of the new grain, or -1 if the bank is full and the steal
+ * policy is STEAL_NONE. Slots change as grains are removed.
+ */
+int GrainBank::trigger(uint8_t channel, WaveType waveType, FreqEnv freqEnv, AmpEnv ampEnv, DurEnv durEnv)
+{
+    int i = acquireSlot();
+    if (i < 0) {
+        return -1;
+    }
+
+    this->channel[i]  = channel;
+    this->waveType[i] = waveType;
+    serial[i]         = triggerCount++;
+    curve[i]          = durEnv.curve;
+    if (curve[i] != 1.0f) {
+        numCurved++;
+    }
+
+    phaseFreq[0][i]     = freqEnv.attackFrequency;
+    phaseFreq[1][i]     = freqEnv.decayFrequency;
+    phaseFreq[2][i]     = freqEnv.sustainFrequency;
+    phaseFreq[3][i]     = freqEnv.releaseFrequency;
+    phaseAmp[0][i]      = ampEnv.attackAmplitude;
+    phaseAmp[1][i]      = ampEnv.decayAmplitude;
+    phaseAmp[2][i]      = ampEnv.sustainAmplitude;
+    phaseAmp[3][i]      = ampEnv.releaseAmplitude;
+    phaseDuration[0][i] = durEnv.attackDuration;
+    phaseDuration[1][i] = durEnv.decayDuration;
+    phaseDuration[2][i] = durEnv.sustainDuration;
+    phaseDuration[3][i] = durEnv.releaseDuration;
+
+    enterPhase(i, ATTACK);
+    if (state[i] == READY) {
+        removeGrain(i);
+        return -1;
+    }
+    return i;
+}
+
+/**
+ * Advances every grain by one window. The envelope of every grain is
+ * evaluated in branch-free loops first; the few grains that finished their
+ * phase are then moved to the next one, and finally the waves are output and
+ * finished grains removed.
+ *
+ * @param batch The WaveBatch to add the waves to, or nullptr to create them
+ * with AudioLab directly.
+ */
+void GrainBank::update(WaveBatch* batch)
+{
+    int n = numActive;
+
+    for (int i = 0; i < n; i++) {
+        progress[i] = (float)(counter[i] + 1) * invDuration[i];
+    }
+
+    // linear grains skip this entirely, curved ones read the shared tables
+    if (numCurved > 0) {
+        for (int i = 0; i < n; i++) {
+            if (curve[i] != 1.0f && counter[i] < duration[i]) {
+                progress[i] = curveTable[i] ? curveTable[i][counter[i]] : powf(progress[i], curve[i]);
+            }
+        }
+    }
+
+    for (int i = 0; i < n; i++) {
+        frequency[i] = startFreq[i] + deltaFreq[i] * progress[i];
+        amplitude[i] = startAmp[i] + deltaAmp[i] * progress[i];
+    }
+
+    for (int i = 0; i < n; i++) {
+        if (counter[i] >= duration[i]) {
+            enterPhase(i, state[i] == RELEASE ? READY : state[i] + 1);
+        }
+    }
+
+    for (int i = 0; i < numActive;) {
+        if (state[i] == READY) {
+            removeGrain(i);
+            continue;
+        }
+        if (batch != nullptr) {
+            batch->add(channel[i], frequency[i], amplitude[i], 0.0, (WaveType)waveType[i]);
+        } else {
+            AudioLab.dynamicWave(channel[i], frequency[i], amplitude[i], 0.0, (WaveType)waveType[i]);
+        }
+        counter[i]++;
+        i++;
+    }
+}
+
+/**
+ * Starts newState, or the first phase after it with a non-zero duration, and
+ * sets the grain's frequency and amplitude for its first window. Mirrors
+ * Grain::transitionTo.
+ *
+ * @param i The slot of the grain.
+ * @param newState The phase to start.
+ */
+void GrainBank::enterPhase(int i, int newState)
+{
+    counter[i] = 0;
+    while (newState != READY && phaseDuration[newState - ATTACK][i] <= 0) {
+        newState = newState == RELEASE ? READY : newState + 1;
+    }
+    state[i] = newState;
+
+    float attackFreq  = phaseFreq[0][i];
+    float attackAmp   = phaseAmp[0][i];
+    float sustainFreq = phaseFreq[2][i];
+    float sustainAmp  = phaseAmp[2][i];
+    switch (newState) {
+    case ATTACK:
+        startFreq[i] = 0.0f;
+        deltaFreq[i] = attackFreq;
+        startAmp[i]  = 0.0f;
+        deltaAmp[i]  = attackAmp;
+        break;
+    case DECAY:
+        startFreq[i] = phaseFreq[1][i];
+        deltaFreq[i] = sustainFreq - attackFreq;
+        startAmp[i]  = phaseAmp[1][i];
+        deltaAmp[i]  = sustainAmp - attackAmp;
+        break;
+    case SUSTAIN:
+        startFreq[i] = sustainFreq;
+        deltaFreq[i] = 0.0f;
+        startAmp[i]  = sustainAmp;
+        deltaAmp[i]  = 0.0f;
+        break;
+    case RELEASE:
+        startFreq[i] = sustainFreq;
+        deltaFreq[i] = phaseFreq[3][i] - sustainFreq;
+        startAmp[i]  = sustainAmp;
+        deltaAmp[i]  = phaseAmp[3][i] - sustainAmp;
+        break;
+    default:
+        frequency[i] = 0.0f;
+        amplitude[i] = 0.0f;
+        return;
+    }
+
+    duration[i]    = phaseDuration[newState - ATTACK][i];
+    invDuration[i] = 1.0f / duration[i];
+    curveTable[i]  = EnvelopeCurveCache::get(duration[i], curve[i]);
+
+    float pos = invDuration[i];
+    if (curveTable[i]) {
+        pos = curveTable[i][0];
+    } else if (curve[i] != 1.0f) {
+        pos = powf(pos, curve[i]);
+    }
+    frequency[i] = startFreq[i] + deltaFreq[i] * pos;
+    amplitude[i] = startAmp[i] + deltaAmp[i] * pos;
+}
+
+/**
+ * Returns the slot for a new grain. If the bank is full, a grain is stolen
+ * according to the steal policy.
+ *
+ * @return The slot, or -1 if the bank is full and the policy is STEAL_NONE
+ */
+int GrainBank::acquireSlot()
+{
+    if (numActive < GRAIN_BANK_SIZE) {
+        return numActive++;
+    }
+    if (stealPolicy == STEAL_NONE) {
+        return -1;
+    }
+
+    int victim = 0;
+    for (int i = 1; i < numActive; i++) {
+        if (stealPolicy == STEAL_QUIETEST ? amplitude[i] < amplitude[victim] : serial[i] < serial[victim]) {
+            victim = i;
+        }
+    }
+    if (curve[victim] != 1.0f) {
+        numCurved--;
+    }
+    return victim;
+}
+
+/**
+ * Removes a grain by moving the last active grain into its slot.
+ *
+ * @param i The slot of the grain to remove.
+ */
+void GrainBank::removeGrain(int i)
+{
+    if (curve[i] != 1.0f) {
+        numCurved--;
+    }
+
+    int last = --numActive;
+    if (i == last) {
+        return;
+    }
+
+    state[i]       = state[last];
+    channel[i]     = channel[last];
+    waveType[i]    = waveType[last];
+    serial[i]      = serial[last];
+    counter[i]     = counter[last];
+    duration[i]    = duration[last];
+    invDuration[i] = invDuration[last];
+    curve[i]       = curve[last];
+    curveTable[i]  = curveTable[last];
+    startFreq[i]   = startFreq[last];
+    deltaFreq[i]   = deltaFreq[last];
+    startAmp[i]    = startAmp[last];
+    deltaAmp[i]    = deltaAmp[last];
+    frequency[i]   = frequency[last];
+    amplitude[i]   = amplitude[last];
+    for (int p = 0; p < 4; p++) {
+        phaseFreq[p][i]     = phaseFreq[p][last];
+        phaseAmp[p][i]      = phaseAmp[p][last];
+        phaseDuration[p][i] = phaseDuration[p][last];
+    }
+}
+
+/**
+ * Removes all grains.
+ */
+void GrainBank::clear()
+{
+    numActive = 0;
+    numCurved = 0;
+}
+
+/**
+ * Returns the number of grains currently running.
+ *
+ * @return int
+ */
+int GrainBank::getNumActive()
+{
+    return numActive;
+}
+
+/**
+ * Returns the current frequency of the grain in slot i.
+ *
+ * @return float
+ */
+float GrainBank::getFrequency(int i)
+{
+    return frequency[i];
+}
+
+/**
+ * Returns the current amplitude of the grain in slot i.
+ *
+ * @return float
+ */
+float GrainBank::getAmplitude(int i)
+{
+    return amplitude[i];
+}
+
+/**
+ * Returns the state of the grain in slot i.
+ *
+ * @return grainState
+ */
+grainState GrainBank::getGrainState(int i)
+{
+    return (grainState)state[i];
+}
+
+/**
+ * Sets how to make room for a new grain when all GRAIN_BANK_SIZE slots are
+ * in use.
+ *
+ * @param policy The grainStealPolicy to use
+ */
+void GrainBank::setStealPolicy(grainStealPolicy policy)
+{
+    stealPolicy = policy;
+}
@@ -0,0 +1,102 @@
+/**
+ * @file
+ * Contains the declaration of the GrainBank class.
+*/
+
+#ifndef GrainBank_h
+#define GrainBank_h
+
+#include <AudioLab.h>
+
+#include "Grain.h"
+
+#ifndef GRAIN_BANK_SIZE
+//! Maximum number of grains a GrainBank can run at once.
+#define GRAIN_BANK_SIZE 128
+#endif
+
+/**
+ * A batch engine for large numbers of dynamic grains.
+ *
+ * Where a GrainList walks a linked list and runs each Grain on its own, a
+ * GrainBank keeps the state of every grain in parallel arrays (structure of
+ * arrays) and advances all of them in a few tight loops over those arrays.
+ * Every envelope phase is stored as a start value and a delta, so each window
+ * a grain's frequency and amplitude are start + delta * progress, where
+ * progress is linear unless the grain has a curve, in which case it is read
+ * from the EnvelopeCurveCache in a separate loop only when such grains exist.
+ *
+ * Grains behave exactly like dynamic Grains triggered in the ATTACK state:
+ * they run through their envelope, output a wave every window, and are
+ * removed when they reach READY. Active grains are kept packed at the front
+ * of the arrays, so removal moves the last grain into the freed slot.
+ */
+class GrainBank {
+private:
+  //! Number of active grains, packed at the front of the arrays
+  int numActive;
+  //! Number of active grains with a non-linear curve
+  int numCurved;
+  //! Incremented every trigger, used to find the oldest grain
+  uint32_t triggerCount;
+  //! How to make room for a grain when the bank is full
+  grainStealPolicy stealPolicy;
+
+  // current phase of each grain
+  uint8_t  state[GRAIN_BANK_SIZE];
+  uint8_t  channel[GRAIN_BANK_SIZE];
+  uint8_t  waveType[GRAIN_BANK_SIZE];
+  uint32_t serial[GRAIN_BANK_SIZE];
+  int      counter[GRAIN_BANK_SIZE];
+  int      duration[GRAIN_BANK_SIZE];
+  float    invDuration[GRAIN_BANK_SIZE];
+  float    curve[GRAIN_BANK_SIZE];
+  const float *curveTable[GRAIN_BANK_SIZE];
+  float    startFreq[GRAIN_BANK_SIZE];
+  float    deltaFreq[GRAIN_BANK_SIZE];
+  float    startAmp[GRAIN_BANK_SIZE];
+  float    deltaAmp[GRAIN_BANK_SIZE];
+  float    progress[GRAIN_BANK_SIZE];
+  float    frequency[GRAIN_BANK_SIZE];
+  float    amplitude[GRAIN_BANK_SIZE];
+
+  // per-phase targets, indexed by state - ATTACK
+  float phaseFreq[4][GRAIN_BANK_SIZE];
+  float phaseAmp[4][GRAIN_BANK_SIZE];
+  int   phaseDuration[4][GRAIN_BANK_SIZE];
+
+  //! Starts the next phase with a non-zero duration, from newState on.
+  void enterPhase(int i, int newState);
+  //! Returns the slot for a new grain, stealing one if the bank is full.
+  int acquireSlot();
+  //! Removes a grain by moving the last active grain into its slot.
+  void removeGrain(int i);
+public:
+  //! Default constructor.
+  GrainBank();
+
+  //! Triggers a new grain with the given envelopes.
+  int trigger(uint8_t channel, WaveType waveType, FreqEnv freqEnv, AmpEnv ampEnv, DurEnv durEnv);
+
+  //! Advances every grain by one window and outputs their waves.
+  void update(WaveBatch* batch = nullptr);
+
+  //! Removes all grains.
+  void clear();
+
+  //! Returns the number of grains currently running.
+  int getNumActive();
+
+  //! Returns the current frequency of the grain in slot i.
+  float getFrequency(int i);
+
+  //! Returns the current amplitude of the grain in slot i.
+  float getAmplitude(int i);
+
+  //! Returns the state of the grain in slot i.
+  grainState getGrainState(int i);
+
+  //! Sets how to make room for a new grain when the bank is full.
+  void setStealPolicy(grainStealPolicy policy);
+};
+#endif
@@ -0,0 +1,357 @@
+/**
+ * @file Kernels.cpp
+ *
+ * The per-bin array kernels, their scalar reference and the backend
+ * specific implementations.
+ */
+
+#include "Kernels.h"
+
+#if defined(KERNELS_ESP_DSP)
+#include <esp_dsp.h>
+#elif defined(KERNELS_AVX) || defined(KERNELS_SSE)
+#include <immintrin.h>
+#elif defined(KERNELS_NEON)
+#include <arm_neon.h>
+#endif
+
+// --- Scalar Reference -----------------------------------------------------------
+
+void Kernels::Reference::add(const float* a, const float* b, float* out, int length)
+{
+    for (int i = 0; i < length; i++) {
+        out[i] = a[i] + b[i];
+    }
+}
+
+void Kernels::Reference::subtract(const float* a, const float* b, float* out, int length)
+{
+    for (int i = 0; i < length; i++) {
+        out[i] = a[i] - b[i];
+    }
+}
+
+void Kernels::Reference::maximum(const float* a, const float* b, float* out, int length)
+{
+    for (int i = 0; i < length; i++) {
+        out[i] = a[i] > b[i] ? a[i] : b[i];
+    }
+}
+
+void Kernels::Reference::minimum(const float* a, const float* b, float* out, int length)
+{
+    for (int i = 0; i < length; i++) {
+        out[i] = a[i] < b[i] ? a[i] : b[i];
+    }
+}
+
+void Kernels::Reference::scale(const float* in, float factor, float* out, int length)
+{
+    for (int i = 0; i < length; i++) {
+        out[i] = in[i] * factor;
+    }
+}
+
+void Kernels::Reference::threshold(const float* in, float floor, float* out, int length)
+{
+    for (int i = 0; i < length; i++) {
+        out[i] = in[i] < floor ? 0.0f : in[i];
+    }
+}
+
+float Kernels::Reference::sum(const float* in, int length)
+{
+    float total = 0.0f;
+    for (int i = 0; i < length; i++) {
+        total += in[i];
+    }
+    return total;
+}
+
+float Kernels::Reference::dot(const float* a, const float* b, int length)
+{
+    float total = 0.0f;
+    for (int i = 0; i < length; i++) {
+        total += a[i] * b[i];
+    }
+    return total;
+}
+
+// --- Vector Backends ------------------------------------------------------------
+
+// Each host backend provides a vector type of VEC_WIDTH floats and the
+// handful of operations below; the kernels are then written once for all
+// of them.
+#if defined(KERNELS_AVX)
+#define KERNELS_VECTOR
+typedef __m256 vec_t;
+static const int VEC_WIDTH = 8;
+static inline vec_t vecLoad(const float* p) { return _mm256_loadu_ps(p); }
+static inline void  vecStore(float* p, vec_t v) { _mm256_storeu_ps(p, v); }
+static inline vec_t vecSet(float x) { return _mm256_set1_ps(x); }
+static inline vec_t vecAdd(vec_t a, vec_t b) { return _mm256_add_ps(a, b); }
+static inline vec_t vecSub(vec_t a, vec_t b) { return _mm256_sub_ps(a, b); }
+static inline vec_t vecMul(vec_t a, vec_t b) { return _mm256_mul_ps(a, b); }
+static inline vec_t vecMax(vec_t a, vec_t b) { return _mm256_max_ps(a, b); }
+static inline vec_t vecMin(vec_t a, vec_t b) { return _mm256_min_ps(a, b); }
+static inline vec_t vecZeroBelow(vec_t v, vec_t floor)
+{
+    return _mm256_and_ps(v, _mm256_cmp_ps(v, floor, _CMP_GE_OQ));
+}
+#elif defined(KERNELS_SSE)
+#define KERNELS_VECTOR
+typedef __m128 vec_t;
+static const int VEC_WIDTH = 4;
+static inline vec_t vecLoad(const float* p) { return _mm_loadu_ps(p); }
+static inline void  vecStore(float* p, vec_t v) { _mm_storeu_ps(p, v); }
+static inline vec_t vecSet(float x) { return _mm_set1_ps(x); }
+static inline vec_t vecAdd(vec_t a, vec_t b) { return _mm_add_ps(a, b); }
+static inline vec_t vecSub(vec_t a, vec_t b) { return _mm_sub_ps(a, b); }
+static inline vec_t vecMul(vec_t a, vec_t b) { return _mm_mul_ps(a, b); }
+static inline vec_t vecMax(vec_t a, vec_t b) { return _mm_max_ps(a, b); }
+static inline vec_t vecMin(vec_t a, vec_t b) { return _mm_min_ps(a, b); }
+static inline vec_t vecZeroBelow(vec_t v, vec_t floor)
+{
+    return _mm_and_ps(v, _mm_cmpge_ps(v, floor));
+}
+#elif defined(KERNELS_NEON)
+#define KERNELS_VECTOR
+typedef float32x4_t vec_t;
+static const int VEC_WIDTH = 4;
+static inline vec_t vecLoad(const float* p) { return vld1q_f32(p); }
+static inline void  vecStore(float* p, vec_t v) { vst1q_f32(p, v); }
+static inline vec_t vecSet(float x) { return vdupq_n_f32(x); }
+static inline vec_t vecAdd(vec_t a, vec_t b) { return vaddq_f32(a, b); }
+static inline vec_t vecSub(vec_t a, vec_t b) { return vsubq_f32(a, b); }
+static inline vec_t vecMul(vec_t a, vec_t b) { return vmulq_f32(a, b); }
+static inline vec_t vecMax(vec_t a, vec_t b) { return vmaxq_f32(a, b); }
+static inline vec_t vecMin(vec_t a, vec_t b) { return vminq_f32(a, b); }
+static inline vec_t vecZeroBelow(vec_t v, vec_t floor)
+{
+    return vreinterpretq_f32_u32(vandq_u32(vreinterpretq_u32_f32(v), vcgeq_f32(v, floor)));
+}
+#endif
+
+#if defined(KERNELS_VECTOR)
+//! Adds up the lanes of a vector.
+static inline float vecReduce(vec_t v)
+{
+    float lanes[VEC_WIDTH];
+    vecStore(lanes, v);
+    float total = 0.0f;
+    for (int i = 0; i < VEC_WIDTH; i++) {
+        total += lanes[i];
+    }
+    return total;
+}
+#endif
+
+// --- Kernels --------------------------------------------------------------------
+
+/**
+ * Returns the name of the backend the kernels were built with, e.g. for
+ * benchmark reports.
+ *
+ * @return "esp-dsp", "avx", "sse", "neon" or "scalar"
+ */
+const char* Kernels::backendName()
+{
+#if defined(KERNELS_ESP_DSP)
+    return "esp-dsp";
+#elif defined(KERNELS_AVX)
+    return "avx";
+#elif defined(KERNELS_SSE)
+    return "sse";
+#elif defined(KERNELS_NEON)
+    return "neon";
+#else
+    return "scalar";
+#endif
+}
+
+/**
+ * Adds two arrays element by element.
+ *
+ * @param a First input.
+ * @param b Second input.
+ * @param out Output, may be a or b.
+ * @param length Number of elements.
+ */
+void Kernels::add(const float* a, const float* b, float* out, int length)
+{
+#if defined(KERNELS_ESP_DSP)
+    dsps_add_f32(a, b, out, length, 1, 1, 1);
+#elif defined(KERNELS_VECTOR)
+    int i = 0;
+    for (; i + VEC_WIDTH <= length; i += VEC_WIDTH) {
+        vecStore(out + i, vecAdd(vecLoad(a + i), vecLoad(b + i)));
+    }
+    Reference::add(a + i, b + i, out + i, length - i);
+#else
+    Reference::add(a, b, out, length);
+#endif
+}
+
+/**
+ * Subtracts one array from another element by element.
+ *
+ * @param a Input to subtract from.
+ * @param b Input to subtract.
+ * @param out Output, may be a or b.
+ * @param length Number of elements.
+ */
+void Kernels::subtract(const float* a, const float* b, float* out, int length)
+{
+#if defined(KERNELS_ESP_DSP)
+    dsps_sub_f32(a, b, out, length, 1, 1, 1);
+#elif defined(KERNELS_VECTOR)
+    int i = 0;
+    for (; i + VEC_WIDTH <= length; i += VEC_WIDTH) {
+        vecStore(out + i, vecSub(vecLoad(a + i), vecLoad(b + i)));
+    }
+    Reference::subtract(a + i, b + i, out + i, length - i);
+#else
+    Reference::subtract(a, b, out, length);
+#endif
+}
+
+/**
+ * Takes the larger of two arrays element by element.
+ *
+ * @param a First input.
+ * @param b Second input.
+ * @param out Output, may be a or b.
+ * @param length Number of elements.
+ */
+void Kernels::maximum(const float* a, const float* b, float* out, int length)
+{
+#if defined(KERNELS_VECTOR)
+    int i = 0;
+    for (; i + VEC_WIDTH <= length; i += VEC_WIDTH) {
+        vecStore(out + i, vecMax(vecLoad(a + i), vecLoad(b + i)));
+    }
+    Reference::maximum(a + i, b + i, out + i, length - i);
+#else
+    Reference::maximum(a, b, out, length);
+#endif
+}
+
+/**
+ * Takes the smaller of two arrays element by element.
+ *
+ * @param a First input.
+ * @param b Second input.
+ * @param out Output, may be a or b.
+ * @param length Number of elements.
+ */
+void Kernels::minimum(const float* a, const float* b, float* out, int length)
+{
+#if defined(KERNELS_VECTOR)
+    int i = 0;
+    for (; i + VEC_WIDTH <= length; i += VEC_WIDTH) {
+        vecStore(out + i, vecMin(vecLoad(a + i), vecLoad(b + i)));
+    }
+    Reference::minimum(a + i, b + i, out + i, length - i);
+#else
+    Reference::minimum(a, b, out, length);
+#endif
+}
+
+/**
+ * Multiplies an array by a constant.
+ *
+ * @param in Input.
+ * @param factor The constant.
+ * @param out Output, may be in.
+ * @param length Number of elements.
+ */
+void Kernels::scale(const float* in, float factor, float* out, int length)
+{
+#if defined(KERNELS_ESP_DSP)
+    dsps_mulc_f32(in, out, length, factor, 1, 1);
+#elif defined(KERNELS_VECTOR)
+    vec_t f = vecSet(factor);
+    int   i = 0;
+    for (; i + VEC_WIDTH <= length; i += VEC_WIDTH) {
+        vecStore(out + i, vecMul(vecLoad(in + i), f));
+    }
+    Reference::scale(in + i, factor, out + i, length - i);
+#else
+    Reference::scale(in, factor, out, length);
+#endif
+}
+
+/**
+ * Zeroes the elements of an array that are below a floor, keeping the rest.
+ * With a floor of 0 this clamps negative values to 0.
+ *
+ * @param in Input.
+ * @param floor The floor.
+ * @param out Output, may be in.
+ * @param length Number of elements.
+ */
+void Kernels::threshold(const float* in, float floor, float* out, int length)
+{
+#if defined(KERNELS_VECTOR)
+    vec_t f = vecSet(floor);
+    int   i = 0;
+    for (; i + VEC_WIDTH <= length; i += VEC_WIDTH) {
+        vecStore(out + i, vecZeroBelow(vecLoad(in + i), f));
+    }
+    Reference::threshold(in + i, floor, out + i, length - i);
+#else
+    Reference::threshold(in, floor, out, length);
+#endif
+}
+
+/**
+ * Returns the sum of an array.
+ *
+ * @param in Input.
+ * @param length Number of elements.
+ * @return float
+ */
+float Kernels::sum(const float* in, int length)
+{
+#if defined(KERNELS_VECTOR)
+    // two accumulators hide the latency of the adds
+    vec_t total0 = vecSet(0.0f);
+    vec_t total1 = vecSet(0.0f);
+    int   i      = 0;
+    for (; i + 2 * VEC_WIDTH <= length; i += 2 * VEC_WIDTH) {
+        total0 = vecAdd(total0, vecLoad(in + i));
+        total1 = vecAdd(total1, vecLoad(in + i + VEC_WIDTH));
+    }
+    return vecReduce(vecAdd(total0, total1)) + Reference::sum(in + i, length - i);
+#else
+    return Reference::sum(in, length);
+#endif
+}
+
+/**
+ * Returns the dot product of two arrays.
+ *
+ * @param a First input.
+ * @param b Second input.
+ * @param length Number of elements.
+ * @return float
+ */
+float Kernels::dot(const float* a, const float* b, int length)
+{
+#if defined(KERNELS_ESP_DSP)
+    float total = 0.0f;
+    dsps_dotprod_f32(a, b, &total, length);
+    return total;
+#elif defined(KERNELS_VECTOR)
+    vec_t total0 = vecSet(0.0f);
+    vec_t total1 = vecSet(0.0f);
+    int   i      = 0;
+    for (; i + 2 * VEC_WIDTH <= length; i += 2 * VEC_WIDTH) {
+        total0 = vecAdd(total0, vecMul(vecLoad(a + i), vecLoad(b + i)));
+        total1 = vecAdd(total1, vecMul(vecLoad(a + i + VEC_WIDTH), vecLoad(b + i + VEC_WIDTH)));
+    }
+    return vecReduce(vecAdd(total0, total1)) + Reference::dot(a + i, b + i, length - i);
+#else
+    return Reference::dot(a, b, length);
+#endif
+}
@@ -0,0 +1,83 @@
+/**
+ * @file
+ * Contains the declarations of the per-bin array kernels.
+*/
+
+#ifndef Kernels_h
+#define Kernels_h
+
+// The backend is picked at compile time: ESP-DSP on the ESP32 when the
+// esp-dsp component is available (its ESP32-S3 builds use the PIE vector
+// unit), AVX, SSE or NEON on the host, and the scalar reference otherwise
+// or when VIBROSONICS_SCALAR_KERNELS is defined.
+#if defined(VIBROSONICS_SCALAR_KERNELS)
+#define KERNELS_SCALAR
+#elif defined(ARDUINO_ARCH_ESP32)
+#if defined(__has_include)
+#if __has_include(<esp_dsp.h>)
+#define KERNELS_ESP_DSP
+#endif
+#endif
+#elif defined(__AVX__)
+#define KERNELS_AVX
+#elif defined(__SSE__) || defined(_M_X64)
+#define KERNELS_SSE
+#elif defined(__ARM_NEON)
+#define KERNELS_NEON
+#endif
+
+/**
+ * Small vectorized kernels for the loops run over WINDOW_SIZE_BY_2 floats
+ * several times per window. Every kernel takes plain float arrays of any
+ * length, handles the tail that does not fill a vector, and allows the
+ * output to be one of its inputs.
+ *
+ * Kernels::Reference holds the plain scalar loop of each kernel, which is
+ * what the backends are checked against and what the kernels fall back to
+ * where a backend has nothing better. Sums and dot products are accumulated
+ * in a different order by the vector backends, so they can differ from the
+ * reference in the last bits.
+ */
+namespace Kernels {
+
+//! Returns the name of the backend the kernels were built with.
+const char* backendName();
+
+//! out[i] = a[i] + b[i]
+void add(const float* a, const float* b, float* out, int length);
+
+//! out[i] = a[i] - b[i]
+void subtract(const float* a, const float* b, float* out, int length);
+
+//! out[i] = the larger of a[i] and b[i]
+void maximum(const float* a, const float* b, float* out, int length);
+
+//! out[i] = the smaller of a[i] and b[i]
+void minimum(const float* a, const float* b, float* out, int length);
+
+//! out[i] = in[i] * factor
+void scale(const float* in, float factor, float* out, int length);
+
+//! out[i] = in[i], or 0 if in[i] is below floor
+void threshold(const float* in, float floor, float* out, int length);
+
+//! Returns the sum of in.
+float sum(const float* in, int length);
+
+//! Returns the dot product of a and b.
+float dot(const float* a, const float* b, int length);
+
+namespace Reference {
+void  add(const float* a, const float* b, float* out, int length);
+void  subtract(const float* a, const float* b, float* out, int length);
+void  maximum(const float* a, const float* b, float* out, int length);
+void  minimum(const float* a, const float* b, float* out, int length);
+void  scale(const float* in, float factor, float* out, int length);
+void  threshold(const float* in, float floor, float* out, int length);
+float sum(const float* in, int length);
+float dot(const float* a, const float* b, int length);
+}
+
+}
+
+#endif
@@ -0,0 +1,229 @@
+/**
+ * @file OscillatorBank.cpp
+ *
+ * This file is part of the OscillatorBank class.
+ */
+
+#include "OscillatorBank.h"
+
+//! Bits of a phase below the table index, interpolated between samples
+static const int      FRACTION_BITS = 32 - TableMath::log2(WAVETABLE_SIZE);
+static const uint32_t FRACTION_MASK = (1u << FRACTION_BITS) - 1;
+static const float    FRACTION_SCALE = 1.0f / (float)(1u << FRACTION_BITS);
+
+/**
+ * Creates a bank without oscillators.
+ */
+OscillatorBank::OscillatorBank()
+{
+    clear();
+}
+
+/**
+ * Returns the table an oscillator reads: the sine table for SINE and COSINE,
+ * otherwise the table of its shape with the most harmonics that all stay
+ * below the Nyquist frequency at the given phase increment.
+ *
+ * @param type The WaveType of the oscillator.
+ * @param increment The largest phase increment of the render.
+ * @return const float*
+ */
+const float* OscillatorBank::tableFor(uint8_t type, uint32_t increment)
+{
+    if (type == SINE || type == COSINE) {
+        return SineTable::values;
+    }
+
+    // the Nyquist frequency is an increment of half a cycle
+    uint32_t maxHarmonic = increment > 0 ? 0x80000000u / increment : 0xFFFFFFFFu;
+    int      level       = 0;
+    while (level < WAVETABLE_LEVELS - 1 && (uint32_t)(WAVETABLE_SIZE / 4 >> level) > maxHarmonic) {
+        level++;
+    }
+    return ShapeTable::values + ((type - SQUARE) * WAVETABLE_LEVELS + level) * (WAVETABLE_SIZE + 1);
+}
+
+/**
+ * Adds a silent oscillator, which starts at phase 0 and sounds once
+ * setOscillator gives it a frequency and amplitude.
+ *
+ * @param channel The output channel it renders into.
+ * @param type The shape of the wave.
+ * @return The index of the oscillator, or -1 if the bank is full.
+ */
+int OscillatorBank::addOscillator(int channel, WaveType type)
+{
+    if (numOscillators >= OSCILLATOR_BANK_SIZE) {
+        Serial.printf("Error: OscillatorBank is full\n");
+        return -1;
+    }
+    int i              = numOscillators++;
+    this->channel[i]   = channel;
+    waveType[i]        = type;
+    phase[i]           = 0;
+    increment[i]       = 0;
+    targetIncrement[i] = 0;
+    amplitude[i]       = 0.0f;
+    targetAmplitude[i] = 0.0f;
+    frequency[i]       = 0.0f;
+    return i;
+}
+
+/**
+ * Sets the frequency and amplitude an oscillator ramps to over the next
+ * render, from the values it reached at the end of the last one.
+ *
+ * @param index The oscillator.
+ * @param freq Frequency in Hz, limited to below the Nyquist frequency.
+ * @param amp Amplitude of the wave.
+ */
+void OscillatorBank::setOscillator(int index, float freq, float amp)
+{
+    if (index < 0 || index >= numOscillators) {
+        Serial.printf("Error: Invalid oscillator index %d\n", index);
+        return;
+    }
+    freq                   = min(max(freq, 0.0f), SAMPLE_RATE / 2.0f - 1.0f);
+    frequency[index]       = freq;
+    targetIncrement[index] = (uint32_t)((double)freq / SAMPLE_RATE * 4294967296.0);
+    targetAmplitude[index] = amp;
+}
+
+/**
+ * Sets the shape of an oscillator, which keeps its phase.
+ *
+ * @param index The oscillator.
+ * @param type The WaveType to render.
+ */
+void OscillatorBank::setWaveType(int index, WaveType type)
+{
+    if (index < 0 || index >= numOscillators) {
+        Serial.printf("Error: Invalid oscillator index %d\n", index);
+        return;
+    }
+    waveType[index] = type;
+}
+
+/**
+ * Sets every oscillator's target amplitude to 0, so the next render fades
+ * them all out. The oscillators keep their frequencies and phases.
+ */
+void OscillatorBank::silence()
+{
+    for (int i = 0; i < numOscillators; i++) {
+        targetAmplitude[i] = 0.0f;
+    }
+}
+
+/**
+ * Removes all oscillators at once, without fading them out.
+ */
+void OscillatorBank::clear()
+{
+    numOscillators = 0;
+}
+
+/**
+ * Renders every oscillator into an interleaved buffer, which is overwritten.
+ * Each oscillator adds into its channel, ramping its phase increment and
+ * amplitude linearly to the targets set since the last render and reading
+ * its table with linear interpolation. Oscillators on channels beyond
+ * numChannels, and silent ones, only advance their phase.
+ *
+ * @param buffer Receives numFrames * numChannels samples.
+ * @param numFrames Number of frames to render, e.g. WINDOW_SIZE.
+ * @param numChannels Number of interleaved channels in buffer.
+ */
+void OscillatorBank::render(float* buffer, int numFrames, int numChannels)
+{
+    for (int i = 0; i < numFrames * numChannels; i++) {
+        buffer[i] = 0.0f;
+    }
+    if (numFrames <= 0) {
+        return;
+    }
+
+    for (int o = 0; o < numOscillators; o++) {
+        uint32_t p    = phase[o];
+        uint32_t inc  = increment[o];
+        int32_t  step = (int32_t)(((int64_t)targetIncrement[o] - inc) / numFrames);
+        float    amp  = amplitude[o];
+
+        if (channel[o] >= numChannels || (amp == 0.0f && targetAmplitude[o] == 0.0f)) {
+            p += inc * (uint32_t)numFrames + (uint32_t)((int64_t)step * numFrames * (numFrames - 1) / 2);
+        } else {
+            const float* table   = tableFor(waveType[o], max(inc, targetIncrement[o]));
+            uint32_t     offset  = waveType[o] == COSINE ? 0x40000000u : 0;
+            float        ampStep = (targetAmplitude[o] - amp) / numFrames;
+            float*       out     = buffer + channel[o];
+            for (int i = 0; i < numFrames; i++) {
+                uint32_t read  = p + offset;
+                uint32_t index = read >> FRACTION_BITS;
+                float    frac  = (read & FRACTION_MASK) * FRACTION_SCALE;
+                float    value = table[index] + (table[index + 1] - table[index]) * frac;
+                out[i * numChannels] += amp * value;
+                p   += inc;
+                inc += step;
+                amp += ampStep;
+            }
+        }
+
+        phase[o]     = p;
+        increment[o] = targetIncrement[o];
+        amplitude[o] = targetAmplitude[o];
+    }
+}
+
+/**
+ * Returns the number of oscillators in the bank.
+ *
+ * @return int
+ */
+int OscillatorBank::getNumOscillators()
+{
+    return numOscillators;
+}
+
+/**
+ * Returns the frequency an oscillator was last set to.
+ *
+ * @param index The oscillator, in range.
+ * @return float
+ */
+float OscillatorBank::getFrequency(int index)
+{
+    return frequency[index];
+}
+
+/**
+ * Returns the amplitude an oscillator was last set to.
+ *
+ * @param index The oscillator, in range.
+ * @return float
+ */
+float OscillatorBank::getAmplitude(int index)
+{
+    return targetAmplitude[index];
+}
+
+/**
+ * Returns the phase an oscillator reached at the end of the last render.
+ *
+ * @param index The oscillator, in range.
+ * @return The phase in cycles, from 0 up to 1.
+ */
+float OscillatorBank::getPhase(int index)
+{
+    return phase[index] / 4294967296.0f;
+}
+
+/**
+ * Returns the bytes of flash the sine and band-limited tables take. They are
+ * constant and shared by every bank, so a bank's own RAM is just its size.
+ *
+ * @return size_t
+ */
+size_t OscillatorBank::tableMemory()
+{
+    return sizeof(SineTable::values) + sizeof(ShapeTable::values);
+}
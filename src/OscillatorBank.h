@@ -0,0 +1,188 @@
+/**
+ * @file
+ * Contains the declaration of the OscillatorBank class.
+*/
+
+#ifndef OscillatorBank_h
+#define OscillatorBank_h
+
+#include <AudioLab.h>
+
+#include "WindowTables.h"
+
+#ifndef OSCILLATOR_BANK_SIZE
+//! Maximum number of oscillators an OscillatorBank can hold.
+#define OSCILLATOR_BANK_SIZE 32
+#endif
+
+#ifndef WAVETABLE_SIZE
+//! Number of samples in one period of a wavetable. A power of two.
+#define WAVETABLE_SIZE 256
+#endif
+
+#ifndef WAVETABLE_LEVELS
+//! Number of band-limited tables per wave shape, each holding half the
+//! harmonics of the one before, starting from WAVETABLE_SIZE / 4.
+#define WAVETABLE_LEVELS 7
+#endif
+
+/**
+ * The band-limited SQUARE, TRIANGLE and SAWTOOTH tables of an OscillatorBank,
+ * generated at compile time from the sine table. The tables are laid out
+ * shape by shape and level by level, each Size + 1 values long. Level l sums
+ * the Fourier series of its shape up to harmonic Size / 4 >> l:
+ *
+ * - SQUARE:    4/pi   * sin(2 pi k t) / k   for odd k
+ * - TRIANGLE: -8/pi^2 * cos(2 pi k t) / k^2 for odd k
+ * - SAWTOOTH: -2/pi   * sin(2 pi k t) / k   for every k
+ *
+ * and is scaled to peak at 1, which also takes care of the constant factors.
+ * The sums are done in float in the order a loop over k would do them.
+ */
+template <int Size, int Levels>
+struct ShapeTableGenerator {
+  typedef ConstTable<float, SineGenerator<Size>, typename MakeIndices<Size + 1>::type> Sine;
+
+  //! Number of harmonics of a level, at least 1.
+  static constexpr int numHarmonics(int level)
+  {
+      return (Size / 4 >> level) > 1 ? Size / 4 >> level : 1;
+  }
+
+  //! Harmonic k of a shape's series at sample i, SQUARE being shape 0.
+  static constexpr float term(int shape, int i, int k)
+  {
+      return shape == 0 ? (k % 2 == 1 ? Sine::values[(k * i) % Size] / k : 0.0f)
+          : shape == 1  ? (k % 2 == 1 ? -(Sine::values[(k * i + Size / 4) % Size] / (k * k)) : 0.0f)
+                        : -(Sine::values[(k * i) % Size] / k);
+  }
+
+  //! Sum of harmonics k and up of a level at sample i, added to sum.
+  static constexpr float series(int shape, int level, int i, int k, float sum)
+  {
+      return k > numHarmonics(level) ? sum : series(shape, level, i, k + 1, sum + term(shape, i, k));
+  }
+
+  //! Unscaled sample i of a table.
+  static constexpr float raw(int shape, int level, int i)
+  {
+      return series(shape, level, i % Size, 1, 0.0f);
+  }
+
+  //! The larger of two magnitudes.
+  static constexpr float larger(float a, float b) { return a > b ? a : b; }
+
+  //! Magnitude of a value.
+  static constexpr float magnitude(float value) { return value < 0.0f ? -value : value; }
+
+  //! Largest magnitude of the unscaled samples first to last - 1 of a table.
+  static constexpr float peak(int shape, int level, int first, int last)
+  {
+      return last - first == 1 ? magnitude(raw(shape, level, first))
+          : larger(peak(shape, level, first, (first + last) / 2), peak(shape, level, (first + last) / 2, last));
+  }
+};
+
+//! Peak of each table of ShapeTableGenerator, indexed by shape * Levels + level.
+template <int Size, int Levels>
+struct ShapePeakGenerator {
+  static constexpr float value(int table)
+  {
+      return ShapeTableGenerator<Size, Levels>::peak(table / Levels, table % Levels, 0, Size);
+  }
+};
+
+//! The samples of every table of ShapeTableGenerator, scaled to peak at 1.
+template <int Size, int Levels>
+struct ShapeSampleGenerator {
+  typedef ConstTable<float, ShapePeakGenerator<Size, Levels>, typename MakeIndices<3 * Levels>::type> Peaks;
+
+  static constexpr float value(int index)
+  {
+      return ShapeTableGenerator<Size, Levels>::raw(index / (Size + 1) / Levels, index / (Size + 1) % Levels,
+                 index % (Size + 1))
+          / Peaks::values[index / (Size + 1)];
+  }
+};
+
+/**
+ * A bank of persistent wavetable oscillators that render straight into a
+ * buffer provided by the caller.
+ *
+ * Unlike the waves created with AudioLab.dynamicWave, which are set up anew
+ * every window, an oscillator lives until the bank is cleared and only gets
+ * a new target frequency and amplitude each window. Its phase is a 32 bit
+ * accumulator that wraps by itself and carries over from one render to the
+ * next, and the frequency and amplitude ramp linearly from their last values
+ * to the targets over each render, so the output has no steps at window
+ * boundaries.
+ *
+ * SINE and COSINE read one sine table. TRIANGLE, SQUARE and SAWTOOTH are
+ * built from their Fourier series into WAVETABLE_LEVELS tables an octave
+ * apart, and each oscillator reads the richest table whose harmonics all
+ * stay below the Nyquist frequency, so they do not alias. The shapes match
+ * AudioLab's and every table peaks at 1. All tables are generated at compile
+ * time into flash and shared by every bank, so a bank costs no table RAM and
+ * no startup time.
+ */
+class OscillatorBank {
+private:
+  int      numOscillators;
+  uint8_t  channel[OSCILLATOR_BANK_SIZE];
+  uint8_t  waveType[OSCILLATOR_BANK_SIZE];
+  //! Phase accumulators, a full cycle is 2^32
+  uint32_t phase[OSCILLATOR_BANK_SIZE];
+  //! Phase increments per sample at the start and end of the next render
+  uint32_t increment[OSCILLATOR_BANK_SIZE];
+  uint32_t targetIncrement[OSCILLATOR_BANK_SIZE];
+  float    amplitude[OSCILLATOR_BANK_SIZE];
+  float    targetAmplitude[OSCILLATOR_BANK_SIZE];
+  float    frequency[OSCILLATOR_BANK_SIZE];
+
+  // one period of each table plus a copy of its first sample, so
+  // interpolation never wraps
+  typedef ConstTable<float, SineGenerator<WAVETABLE_SIZE>,
+      MakeIndices<WAVETABLE_SIZE + 1>::type> SineTable;
+  typedef ConstTable<float, ShapeSampleGenerator<WAVETABLE_SIZE, WAVETABLE_LEVELS>,
+      MakeIndices<3 * WAVETABLE_LEVELS * (WAVETABLE_SIZE + 1)>::type> ShapeTable;
+
+  //! Returns the table an oscillator of a type reads at a phase increment.
+  static const float* tableFor(uint8_t type, uint32_t increment);
+public:
+  //! Default constructor.
+  OscillatorBank();
+
+  //! Adds a silent oscillator and returns its index.
+  int addOscillator(int channel, WaveType type = SINE);
+
+  //! Sets the frequency and amplitude an oscillator ramps to in the next render.
+  void setOscillator(int index, float freq, float amp);
+
+  //! Sets the shape of an oscillator.
+  void setWaveType(int index, WaveType type);
+
+  //! Ramps every oscillator to silence in the next render.
+  void silence();
+
+  //! Removes all oscillators.
+  void clear();
+
+  //! Renders interleaved frames of every oscillator into buffer.
+  void render(float* buffer, int numFrames, int numChannels);
+
+  //! Returns the number of oscillators.
+  int getNumOscillators();
+
+  //! Returns the target frequency of an oscillator.
+  float getFrequency(int index);
+
+  //! Returns the target amplitude of an oscillator.
+  float getAmplitude(int index);
+
+  //! Returns the phase of an oscillator in cycles, from 0 to 1.
+  float getPhase(int index);
+
+  //! Returns the bytes of flash the wavetables shared by all banks take.
+  static size_t tableMemory();
+};
+#endif
@@ -0,0 +1,233 @@
+/**
+ * @file PercussiveMelodicSplit.cpp
+ *
+ * This file is part of the PercussiveMelodicSplit class.
+ */
+
+#include "PercussiveMelodicSplit.h"
+
+#if SPLIT_MEDIAN_FRAMES > 0
+static_assert(SPLIT_MEDIAN_FRAMES % 2 == 1, "SPLIT_MEDIAN_FRAMES must be odd");
+#endif
+static_assert(SPLIT_MEDIAN_BINS % 2 == 1, "SPLIT_MEDIAN_BINS must be odd");
+
+/**
+ * Creates a SPLIT_SMOOTHED split with the Vibrosonics example's smoothing
+ * factors and no noise floor.
+ */
+PercussiveMelodicSplit::PercussiveMelodicSplit()
+{
+    method              = SPLIT_SMOOTHED;
+    percussiveSmoothing = 0.2f;
+    melodicSmoothing    = 0.3f;
+    melodicFloor        = 0.0f;
+    reset();
+}
+
+/**
+ * Splits a spectrum into its percussive and melodic parts, which stay
+ * available through getPercussive and getMelodic until the next call.
+ *
+ * @param raw WINDOW_SIZE_BY_2 magnitudes, as from processAudioInput.
+ * @param filtered The same magnitudes cleaned up, e.g. by noiseFloorCFAR,
+ * which the state follows. May be raw itself.
+ */
+void PercussiveMelodicSplit::process(const float* raw, const float* filtered)
+{
+#if SPLIT_MEDIAN_FRAMES > 0
+    if (method == SPLIT_MEDIAN) {
+        splitMedian(raw, filtered);
+        return;
+    }
+#endif
+    splitSmoothed(raw, filtered);
+}
+
+/**
+ * Updates both smoothed spectra and computes both outputs in a single
+ * branch-free pass over the bins.
+ *
+ * @param raw The spectrum to split.
+ * @param filtered The spectrum the smoothings follow.
+ */
+void PercussiveMelodicSplit::splitSmoothed(const float* raw, const float* filtered)
+{
+    const float moreKeep = 1.0f - percussiveSmoothing;
+    const float lessKeep = 1.0f - melodicSmoothing;
+    for (int i = 0; i < WINDOW_SIZE / 2; i++) {
+        float more = percussiveSmoothing * filtered[i] + moreKeep * smoothed.moreSmoothed[i];
+        float less = melodicSmoothing * filtered[i] + lessKeep * smoothed.lessSmoothed[i];
+        smoothed.moreSmoothed[i] = more;
+        smoothed.lessSmoothed[i] = less;
+
+        float mel     = fminf(raw[i], less);
+        percussive[i] = fmaxf(raw[i] - more, 0.0f);
+        melodic[i]    = mel < melodicFloor ? 0.0f : mel;
+    }
+}
+
+#if SPLIT_MEDIAN_FRAMES > 0
+/**
+ * Updates the time median of every bin with the new spectrum, slides the
+ * frequency median across it, and divides each bin between the outputs by
+ * Wiener-like masks: the percussive share is P^2 / (P^2 + H^2), where P is
+ * the frequency median and H the time median.
+ *
+ * @param raw The spectrum to split.
+ * @param filtered The spectrum the medians are taken of.
+ */
+void PercussiveMelodicSplit::splitMedian(const float* raw, const float* filtered)
+{
+    const int half = SPLIT_MEDIAN_BINS / 2;
+
+    // frequency window of bin 0, bins outside the spectrum count as 0
+    for (int j = 0; j < SPLIT_MEDIAN_BINS; j++) {
+        int bin       = j - half;
+        freqSorted[j] = bin >= 0 && bin < WINDOW_SIZE / 2 ? filtered[bin] : 0.0f;
+    }
+    for (int j = 1; j < SPLIT_MEDIAN_BINS; j++) {
+        replaceSorted(freqSorted, j + 1, freqSorted[j], freqSorted[j]);
+    }
+
+    for (int i = 0; i < WINDOW_SIZE / 2; i++) {
+        // the oldest value of the bin leaves its time window
+        replaceSorted(median.timeSorted[i], SPLIT_MEDIAN_FRAMES, median.timeHistory[historyPosition][i], filtered[i]);
+        median.timeHistory[historyPosition][i] = filtered[i];
+
+        float h  = median.timeSorted[i][SPLIT_MEDIAN_FRAMES / 2];
+        float p  = freqSorted[half];
+        float h2 = h * h;
+        float p2 = p * p;
+        float total = h2 + p2;
+
+        percussive[i] = total > 0.0f ? raw[i] * p2 / total : 0.0f;
+        float mel     = total > 0.0f ? raw[i] * h2 / total : 0.0f;
+        melodic[i]    = mel < melodicFloor ? 0.0f : mel;
+
+        // slide the frequency window on to the next bin
+        int leaving  = i - half;
+        int entering = i + half + 1;
+        replaceSorted(freqSorted, SPLIT_MEDIAN_BINS,
+            leaving >= 0 ? filtered[leaving] : 0.0f,
+            entering < WINDOW_SIZE / 2 ? filtered[entering] : 0.0f);
+    }
+    historyPosition = (historyPosition + 1) % SPLIT_MEDIAN_FRAMES;
+}
+
+/**
+ * Replaces a value of a sorted array with another, moving the new value to
+ * its sorted position. Also used to insertion sort an array: replacing the
+ * last element of a sorted prefix with itself moves it into place.
+ *
+ * @param sorted The sorted array.
+ * @param length Number of values in the array.
+ * @param oldValue A value in the array.
+ * @param newValue The value to replace it with.
+ */
+void PercussiveMelodicSplit::replaceSorted(float* sorted, int length, float oldValue, float newValue)
+{
+    int i = length - 1;
+    while (i > 0 && sorted[i] != oldValue) {
+        i--;
+    }
+    while (i > 0 && sorted[i - 1] > newValue) {
+        sorted[i] = sorted[i - 1];
+        i--;
+    }
+    while (i < length - 1 && sorted[i + 1] < newValue) {
+        sorted[i] = sorted[i + 1];
+        i++;
+    }
+    sorted[i] = newValue;
+}
+#endif
+
+/**
+ * Returns the percussive part of the last spectrum. The array belongs to the
+ * split and may be changed in place.
+ *
+ * @return WINDOW_SIZE_BY_2 magnitudes
+ */
+float* PercussiveMelodicSplit::getPercussive()
+{
+    return percussive;
+}
+
+/**
+ * Returns the melodic part of the last spectrum. The array belongs to the
+ * split and may be changed in place.
+ *
+ * @return WINDOW_SIZE_BY_2 magnitudes
+ */
+float* PercussiveMelodicSplit::getMelodic()
+{
+    return melodic;
+}
+
+/**
+ * Sets how percussive and melodic energy are told apart, clearing the state
+ * of the previous method. SPLIT_MEDIAN needs SPLIT_MEDIAN_FRAMES defined.
+ *
+ * @param method The splitMethod to use
+ * @return false if the method was not changed.
+ */
+bool PercussiveMelodicSplit::setMethod(splitMethod method)
+{
+#if SPLIT_MEDIAN_FRAMES == 0
+    if (method == SPLIT_MEDIAN) {
+        Serial.printf("Error: SPLIT_MEDIAN needs SPLIT_MEDIAN_FRAMES defined, e.g. as 7.\n");
+        return false;
+    }
+#endif
+    this->method = method;
+    reset();
+    return true;
+}
+
+/**
+ * Sets the smoothing factors of SPLIT_SMOOTHED, the weight each new spectrum
+ * gets in the smoothed spectra, as in AudioPrism::smooth_window_over_time.
+ *
+ * @param percussiveSmoothing Factor of the slow smoothing that percussive
+ * energy rises above.
+ * @param melodicSmoothing Factor of the faster smoothing that caps melodic
+ * energy.
+ */
+void PercussiveMelodicSplit::setSmoothing(float percussiveSmoothing, float melodicSmoothing)
+{
+    this->percussiveSmoothing = percussiveSmoothing;
+    this->melodicSmoothing    = melodicSmoothing;
+}
+
+/**
+ * Sets the level below which melodic bins are zeroed.
+ *
+ * @param melodicFloor The noise floor, 0 to keep every bin.
+ */
+void PercussiveMelodicSplit::setNoiseFloor(float melodicFloor)
+{
+    this->melodicFloor = melodicFloor;
+}
+
+/**
+ * Clears the smoothed spectra and the median history, as if no window had
+ * been processed.
+ */
+void PercussiveMelodicSplit::reset()
+{
+    for (int i = 0; i < WINDOW_SIZE / 2; i++) {
+        percussive[i]            = 0.0f;
+        melodic[i]               = 0.0f;
+        smoothed.moreSmoothed[i] = 0.0f;
+        smoothed.lessSmoothed[i] = 0.0f;
+#if SPLIT_MEDIAN_FRAMES > 0
+        for (int j = 0; j < SPLIT_MEDIAN_FRAMES; j++) {
+            median.timeHistory[j][i] = 0.0f;
+            median.timeSorted[i][j]  = 0.0f;
+        }
+#endif
+    }
+#if SPLIT_MEDIAN_FRAMES > 0
+    historyPosition = 0;
+#endif
+}
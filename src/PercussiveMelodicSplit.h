@@ -0,0 +1,120 @@
+/**
+ * @file
+ * Contains the declaration of the PercussiveMelodicSplit class.
+*/
+
+#ifndef PercussiveMelodicSplit_h
+#define PercussiveMelodicSplit_h
+
+#include <AudioLab.h>
+
+#ifndef SPLIT_MEDIAN_FRAMES
+//! Number of windows the SPLIT_MEDIAN time median runs over. Odd; the
+//! default of 0 compiles the median state out, leaving only SPLIT_SMOOTHED,
+//! so define it, e.g. as 7, to use SPLIT_MEDIAN.
+#define SPLIT_MEDIAN_FRAMES 0
+#endif
+
+#ifndef SPLIT_MEDIAN_BINS
+//! Number of bins the SPLIT_MEDIAN frequency median runs over. Odd.
+#define SPLIT_MEDIAN_BINS 7
+#endif
+
+/**
+ * @type splitMethod
+ *
+ * Enum for how PercussiveMelodicSplit tells percussive from melodic energy.
+ */
+enum splitMethod {
+  SPLIT_SMOOTHED, //!< Against exponentially smoothed spectra, as in the Vibrosonics example
+  SPLIT_MEDIAN    //!< Median filtering over time and over frequency (HPSS)
+};
+
+/**
+ * Splits each spectrum into a percussive and a melodic spectrum, keeping the
+ * state it needs from window to window.
+ *
+ * SPLIT_SMOOTHED follows the spectrum with a slow and a faster exponential
+ * smoothing. What rises above the slow one is percussive; the melodic part
+ * is the spectrum capped by the faster one, so it adapts when the spectrum
+ * drops quickly. Both smoothings and both outputs are done in one pass.
+ *
+ * SPLIT_MEDIAN is median filtering harmonic/percussive separation: melodic
+ * energy is steady over time, so it survives a median over the last
+ * SPLIT_MEDIAN_FRAMES windows of each bin, and percussive energy is spread
+ * over frequency, so it survives a median over SPLIT_MEDIAN_BINS neighbouring
+ * bins. The spectrum is then divided between the two outputs by soft masks
+ * from the two medians. Both medians are kept in sorted arrays that are
+ * updated by replacing a single value, instead of being sorted again. Its
+ * state takes SPLIT_MEDIAN_FRAMES times as much memory as SPLIT_SMOOTHED's,
+ * so it is only compiled in when SPLIT_MEDIAN_FRAMES is defined.
+ *
+ * In both methods, melodic bins below the noise floor are zeroed.
+ */
+class PercussiveMelodicSplit {
+private:
+  splitMethod method;
+  float percussiveSmoothing;
+  float melodicSmoothing;
+  float melodicFloor;
+
+  float percussive[WINDOW_SIZE / 2];
+  float melodic[WINDOW_SIZE / 2];
+
+  // Only the current method's state is kept, setMethod clears it, so the
+  // spectra of both methods share memory
+  union {
+    // SPLIT_SMOOTHED state
+    struct {
+      float moreSmoothed[WINDOW_SIZE / 2];
+      float lessSmoothed[WINDOW_SIZE / 2];
+    } smoothed;
+
+#if SPLIT_MEDIAN_FRAMES > 0
+    // SPLIT_MEDIAN state: the last SPLIT_MEDIAN_FRAMES values of each bin,
+    // in arrival order and sorted
+    struct {
+      float timeHistory[SPLIT_MEDIAN_FRAMES][WINDOW_SIZE / 2];
+      float timeSorted[WINDOW_SIZE / 2][SPLIT_MEDIAN_FRAMES];
+    } median;
+#endif
+  };
+#if SPLIT_MEDIAN_FRAMES > 0
+  int   historyPosition;
+  float freqSorted[SPLIT_MEDIAN_BINS];
+#endif
+
+  //! Splits with the smoothed spectra.
+  void splitSmoothed(const float* raw, const float* filtered);
+#if SPLIT_MEDIAN_FRAMES > 0
+  //! Splits with the time and frequency medians.
+  void splitMedian(const float* raw, const float* filtered);
+  //! Replaces oldValue with newValue in a sorted array, keeping it sorted.
+  static void replaceSorted(float* sorted, int length, float oldValue, float newValue);
+#endif
+public:
+  //! Default constructor.
+  PercussiveMelodicSplit();
+
+  //! Splits a spectrum into its percussive and melodic parts.
+  void process(const float* raw, const float* filtered);
+
+  //! Returns the percussive part of the last spectrum.
+  float* getPercussive();
+
+  //! Returns the melodic part of the last spectrum.
+  float* getMelodic();
+
+  //! Sets how percussive and melodic energy are told apart.
+  bool setMethod(splitMethod method);
+
+  //! Sets the smoothing factors of SPLIT_SMOOTHED.
+  void setSmoothing(float percussiveSmoothing, float melodicSmoothing);
+
+  //! Sets the level below which melodic bins are zeroed.
+  void setNoiseFloor(float melodicFloor);
+
+  //! Clears the state kept from previous windows.
+  void reset();
+};
+#endif
@@ -0,0 +1,195 @@
+/**
+ * @file Profiler.cpp
+ *
+ * This file is part of the StageProfiler class.
+ */
+
+#include "Profiler.h"
+
+#ifdef VIBROSONICS_PROFILE
+
+#include <AudioLab.h>
+#include <string.h>
+
+/**
+ * Creates a profiler with no stages.
+ */
+StageProfiler::StageProfiler()
+{
+    numStages = 0;
+}
+
+/**
+ * Returns the histogram bucket for a tick count. Counts below 4 get a bucket
+ * each; above that every power of two is split into four buckets by the two
+ * bits below the leading one.
+ *
+ * @param ticks The tick count.
+ * @return int
+ */
+int StageProfiler::bucketOf(uint32_t ticks)
+{
+    if (ticks < 4) {
+        return ticks;
+    }
+    int msb = 31 - __builtin_clz(ticks);
+    return msb * 4 + ((ticks >> (msb - 2)) & 3);
+}
+
+/**
+ * Returns the largest tick count that falls into a bucket.
+ *
+ * @param bucket The bucket index.
+ * @return uint32_t
+ */
+uint32_t StageProfiler::bucketUpperBound(int bucket)
+{
+    if (bucket < 4) {
+        return bucket;
+    }
+    int msb = bucket / 4;
+    uint64_t lower = (uint64_t)(4 + bucket % 4) << (msb - 2);
+    return (uint32_t)(lower + ((uint64_t)1 << (msb - 2)) - 1);
+}
+
+/**
+ * Returns the number of ticks in a microsecond for the platform's clock.
+ *
+ * @return float
+ */
+float StageProfiler::ticksPerMicrosecond()
+{
+#if defined(ARDUINO_ARCH_ESP32)
+    return ESP.getCpuFreqMHz();
+#elif defined(ARDUINO)
+    return 1.0f;
+#else
+    return 1000.0f;
+#endif
+}
+
+/**
+ * Returns the index of the stage with the given name, adding a new stage if
+ * there is none. Names are compared by pointer first, so passing the same
+ * string literal each time avoids string comparisons.
+ *
+ * @param name The name of the stage. The string must outlive the profiler.
+ * @return The stage index, or -1 if PROFILER_MAX_STAGES stages already exist.
+ */
+int StageProfiler::getStage(const char* name)
+{
+    for (int i = 0; i < numStages; i++) {
+        if (stages[i].name == name) {
+            return i;
+        }
+    }
+    for (int i = 0; i < numStages; i++) {
+        if (strcmp(stages[i].name, name) == 0) {
+            return i;
+        }
+    }
+    if (numStages == PROFILER_MAX_STAGES) {
+        return -1;
+    }
+
+    Stage& stage = stages[numStages];
+    stage.name = name;
+    memset(stage.histogram, 0, sizeof(stage.histogram));
+    stage.count      = 0;
+    stage.minTicks   = UINT32_MAX;
+    stage.maxTicks   = 0;
+    stage.totalTicks = 0;
+    return numStages++;
+}
+
+/**
+ * Adds a measurement to a stage.
+ *
+ * @param stage The stage index from getStage; -1 is ignored.
+ * @param ticks The duration in ticks.
+ */
+void StageProfiler::record(int stage, uint32_t ticks)
+{
+    if (stage < 0) {
+        return;
+    }
+    Stage& s = stages[stage];
+    s.count++;
+    s.totalTicks += ticks;
+    if (ticks < s.minTicks) {
+        s.minTicks = ticks;
+    }
+    if (ticks > s.maxTicks) {
+        s.maxTicks = ticks;
+    }
+    s.histogram[bucketOf(ticks)]++;
+}
+
+/**
+ * Returns the estimated 99th percentile of a stage: the upper bound of the
+ * histogram bucket holding it, capped at the stage's maximum.
+ *
+ * @param stage The stage index from getStage.
+ * @return The percentile in ticks, or 0 if the stage has no measurements.
+ */
+uint32_t StageProfiler::getPercentile99(int stage)
+{
+    const Stage& s = stages[stage];
+    if (s.count == 0) {
+        return 0;
+    }
+    uint32_t target = s.count - s.count / 100;
+    uint32_t seen   = 0;
+    for (int b = 0; b < PROFILER_BUCKETS; b++) {
+        seen += s.histogram[b];
+        if (seen >= target) {
+            return min(bucketUpperBound(b), s.maxTicks);
+        }
+    }
+    return s.maxTicks;
+}
+
+/**
+ * Prints the count, minimum, mean, maximum and 99th percentile of every
+ * stage in microseconds, along with the maximum and 99th percentile as a
+ * percentage of the window deadline, WINDOW_SIZE / SAMPLE_RATE.
+ */
+void StageProfiler::report()
+{
+    float tpu        = ticksPerMicrosecond();
+    float deadlineUs = 1e6f * WINDOW_SIZE / SAMPLE_RATE;
+
+    Serial.printf("window deadline: %.0f us\n", deadlineUs);
+    Serial.printf("%-20s %8s %10s %10s %10s %10s %7s %7s\n", "stage", "count", "min us",
+        "mean us", "max us", "p99 us", "max %", "p99 %");
+    for (int i = 0; i < numStages; i++) {
+        const Stage& s = stages[i];
+        if (s.count == 0) {
+            continue;
+        }
+        float minUs  = s.minTicks / tpu;
+        float meanUs = (float)s.totalTicks / s.count / tpu;
+        float maxUs  = s.maxTicks / tpu;
+        float p99Us  = getPercentile99(i) / tpu;
+        Serial.printf("%-20s %8u %10.1f %10.1f %10.1f %10.1f %6.1f%% %6.1f%%\n", s.name,
+            (unsigned)s.count, minUs, meanUs, maxUs, p99Us, 100 * maxUs / deadlineUs,
+            100 * p99Us / deadlineUs);
+    }
+}
+
+/**
+ * Clears the statistics of every stage, keeping the stage names.
+ */
+void StageProfiler::reset()
+{
+    for (int i = 0; i < numStages; i++) {
+        Stage& s = stages[i];
+        memset(s.histogram, 0, sizeof(s.histogram));
+        s.count      = 0;
+        s.minTicks   = UINT32_MAX;
+        s.maxTicks   = 0;
+        s.totalTicks = 0;
+    }
+}
+
+#endif // VIBROSONICS_PROFILE
@@ -0,0 +1,123 @@
+/**
+ * @file
+ * Contains the declaration of the StageProfiler class and the
+ * VIBROSONICS_PROFILE_SCOPE macro.
+*/
+
+#ifndef Profiler_h
+#define Profiler_h
+
+#include <Arduino.h>
+#include <stdint.h>
+
+#ifdef VIBROSONICS_PROFILE
+
+#if !defined(ARDUINO)
+#include <chrono>
+#endif
+
+#ifndef PROFILER_MAX_STAGES
+//! Maximum number of named stages a StageProfiler can track.
+#define PROFILER_MAX_STAGES 16
+#endif
+
+//! Histogram buckets per stage: four per power of two of a 32 bit tick count.
+#define PROFILER_BUCKETS 128
+
+/**
+ * Collects timing statistics for named stages of the window loop.
+ *
+ * Every stage keeps its count, minimum, maximum and total time along with a
+ * log scale histogram (four buckets per doubling, so within 19%) from which
+ * the 99th percentile is estimated. Memory is fixed: nothing is allocated
+ * while profiling.
+ *
+ * Time is measured in ticks: CPU cycles from ESP.getCycleCount() on the
+ * ESP32, microseconds from micros() on other Arduino boards, and nanoseconds
+ * from std::chrono on the host. Stages are usually timed with
+ * VIBROSONICS_PROFILE_SCOPE rather than by calling record directly.
+ */
+class StageProfiler {
+private:
+  struct Stage {
+    const char* name;
+    uint32_t count;
+    uint32_t minTicks;
+    uint32_t maxTicks;
+    uint64_t totalTicks;
+    uint32_t histogram[PROFILER_BUCKETS];
+  };
+
+  Stage stages[PROFILER_MAX_STAGES];
+  int numStages;
+
+  //! Returns the histogram bucket for a tick count.
+  static int bucketOf(uint32_t ticks);
+  //! Returns the largest tick count that falls into a bucket.
+  static uint32_t bucketUpperBound(int bucket);
+public:
+  //! Default constructor.
+  StageProfiler();
+
+  //! Returns the current time in ticks.
+  static uint32_t now()
+  {
+#if defined(ARDUINO_ARCH_ESP32)
+      return ESP.getCycleCount();
+#elif defined(ARDUINO)
+      return micros();
+#else
+      return (uint32_t)std::chrono::duration_cast<std::chrono::nanoseconds>(
+          std::chrono::steady_clock::now().time_since_epoch()).count();
+#endif
+  }
+
+  //! Returns the number of ticks in a microsecond.
+  static float ticksPerMicrosecond();
+
+  //! Returns the index of a named stage, adding it if needed.
+  int getStage(const char* name);
+
+  //! Adds a measurement to a stage.
+  void record(int stage, uint32_t ticks);
+
+  //! Returns the estimated 99th percentile of a stage, in ticks.
+  uint32_t getPercentile99(int stage);
+
+  //! Prints the statistics of every stage against the window deadline.
+  void report();
+
+  //! Clears the statistics of every stage.
+  void reset();
+};
+
+/**
+ * Times the scope it is declared in and records it to a stage on exit.
+ */
+class ScopedTimer {
+private:
+  StageProfiler& profiler;
+  int stage;
+  uint32_t start;
+public:
+  ScopedTimer(StageProfiler& profiler, const char* name)
+      : profiler(profiler), stage(profiler.getStage(name)), start(StageProfiler::now()) {}
+
+  ~ScopedTimer() { profiler.record(stage, StageProfiler::now() - start); }
+};
+
+#define VIBROSONICS_PROFILE_CONCAT_(a, b) a##b
+#define VIBROSONICS_PROFILE_CONCAT(a, b) VIBROSONICS_PROFILE_CONCAT_(a, b)
+
+//! Times the rest of the enclosing scope as the named stage of a profiler.
+#define VIBROSONICS_PROFILE_SCOPE(profiler, name) \
+  ScopedTimer VIBROSONICS_PROFILE_CONCAT(profileTimer, __LINE__)((profiler), (name))
+
+#else
+
+//! Profiling is compiled out unless VIBROSONICS_PROFILE is defined.
+#define VIBROSONICS_PROFILE_SCOPE(profiler, name) ((void)0)
+
+#endif // VIBROSONICS_PROFILE
+
+#endif
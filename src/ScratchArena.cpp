@@ -0,0 +1,92 @@
+/**
+ * @file ScratchArena.cpp
+ *
+ * This file is part of the ScratchArena class.
+ */
+
+#include "ScratchArena.h"
+
+static_assert((SCRATCH_ARENA_ALIGN & (SCRATCH_ARENA_ALIGN - 1)) == 0, "SCRATCH_ARENA_ALIGN must be a power of two");
+
+/**
+ * Creates an empty arena.
+ */
+ScratchArena::ScratchArena()
+{
+    used          = 0;
+    highWaterMark = 0;
+}
+
+/**
+ * Hands out the next span of the arena, aligned to SCRATCH_ARENA_ALIGN. The
+ * span stays valid until the next reset, and is not cleared.
+ *
+ * @param bytes The size of the span.
+ * @return The span, or nullptr if it does not fit in what is left of the
+ * arena. The request still counts towards the high-water mark.
+ */
+void* ScratchArena::allocate(size_t bytes)
+{
+    size_t start = (used + SCRATCH_ARENA_ALIGN - 1) & ~(size_t)(SCRATCH_ARENA_ALIGN - 1);
+    size_t end   = start + bytes;
+    if (end > highWaterMark) {
+        highWaterMark = end;
+    }
+    if (end > SCRATCH_ARENA_SIZE) {
+        Serial.printf("Error: scratch arena is full, %u of %u bytes requested. Increase SCRATCH_ARENA_SIZE.\n",
+            (unsigned)end, (unsigned)SCRATCH_ARENA_SIZE);
+        return nullptr;
+    }
+    used = end;
+    return buffer + start;
+}
+
+/**
+ * Frees every span handed out, so the next window starts from an empty
+ * arena. Spans from before the reset must no longer be used.
+ */
+void ScratchArena::reset()
+{
+    used = 0;
+}
+
+/**
+ * Returns the bytes handed out since the last reset, including the padding
+ * that aligns each span.
+ *
+ * @return size_t
+ */
+size_t ScratchArena::getUsed()
+{
+    return used;
+}
+
+/**
+ * Returns the most bytes, with padding, requested between two resets since
+ * the arena was created or the mark was last reset. A high-water mark above
+ * getCapacity means some requests were refused.
+ *
+ * @return size_t
+ */
+size_t ScratchArena::getHighWaterMark()
+{
+    return highWaterMark;
+}
+
+/**
+ * Sets the high-water mark to what is handed out right now.
+ */
+void ScratchArena::resetHighWaterMark()
+{
+    highWaterMark = used;
+}
+
+/**
+ * Returns the size of the arena, SCRATCH_ARENA_SIZE.
+ *
+ * @return size_t
+ */
+size_t ScratchArena::getCapacity()
+{
+    return SCRATCH_ARENA_SIZE;
+}
@@ -0,0 +1,82 @@
+/**
+ * @file
+ * Contains the declaration of the ScratchArena class.
+*/
+
+#ifndef ScratchArena_h
+#define ScratchArena_h
+
+#include <AudioLab.h>
+
+#include <stddef.h>
+#include <stdint.h>
+
+#ifndef SCRATCH_ARENA_SIZE
+//! Bytes of scratch a ScratchArena hands out per window, by default room for
+//! two spectra of WINDOW_SIZE / 2 floats, or one with VIBROSONICS_LOW_MEMORY.
+//! Size it with getHighWaterMark.
+#ifdef VIBROSONICS_LOW_MEMORY
+#define SCRATCH_ARENA_SIZE ((WINDOW_SIZE / 2) * sizeof(float))
+#else
+#define SCRATCH_ARENA_SIZE (2 * (WINDOW_SIZE / 2) * sizeof(float))
+#endif
+#endif
+
+#ifndef SCRATCH_ARENA_ALIGN
+//! Alignment of every span a ScratchArena hands out, in bytes, enough for
+//! the vector kernels. A power of two.
+#define SCRATCH_ARENA_ALIGN 16
+#endif
+
+/**
+ * A bump allocator for the temporary buffers of a window, such as the
+ * filtered or melodic spectrum a sketch computes from the raw one and then
+ * hands on to analysis.
+ *
+ * Spans come from one fixed buffer, each aligned to SCRATCH_ARENA_ALIGN, by
+ * moving an offset forward; they are not freed one by one but all at once by
+ * reset, which VibrosonicsAPI calls at the start of every window. Spans are
+ * not cleared, and nothing that must last past the window, like a spectrum
+ * smoothed over time, belongs in one.
+ *
+ * The arena remembers the most it was ever asked for in one window,
+ * including requests it had to refuse, so a program can be run for a while
+ * and SCRATCH_ARENA_SIZE set to its high-water mark.
+ */
+class ScratchArena {
+private:
+  alignas(SCRATCH_ARENA_ALIGN) uint8_t buffer[SCRATCH_ARENA_SIZE];
+  size_t used;
+  size_t highWaterMark;
+public:
+  //! Default constructor.
+  ScratchArena();
+
+  //! Returns an aligned span of bytes, or nullptr if the arena is full.
+  void* allocate(size_t bytes);
+
+  //! Returns an aligned span of count values of type T, or nullptr if the
+  //! arena is full.
+  template <typename T>
+  T* allocate(int count)
+  {
+      static_assert(alignof(T) <= SCRATCH_ARENA_ALIGN, "type needs more alignment than SCRATCH_ARENA_ALIGN");
+      return static_cast<T*>(allocate(count * sizeof(T)));
+  }
+
+  //! Frees every span for the next window.
+  void reset();
+
+  //! Returns the bytes handed out since the last reset, with padding.
+  size_t getUsed();
+
+  //! Returns the most bytes ever requested between two resets.
+  size_t getHighWaterMark();
+
+  //! Forgets the high-water mark, e.g. after a warm-up.
+  void resetHighWaterMark();
+
+  //! Returns SCRATCH_ARENA_SIZE.
+  size_t getCapacity();
+};
+#endif
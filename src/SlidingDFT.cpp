@@ -0,0 +1,233 @@
+/**
+ * @file SlidingDFT.cpp
+ *
+ * This file is part of the SlidingDFT class.
+ */
+
+#include "SlidingDFT.h"
+#include <math.h>
+
+/**
+ * Creates a bank that tracks no bins.
+ */
+SlidingDFT::SlidingDFT()
+{
+    dampingN = powf(SLIDING_DFT_DAMPING, WINDOW_SIZE);
+    clear();
+}
+
+/**
+ * Starts tracking a bin. Magnitudes are only meaningful once WINDOW_SIZE
+ * samples have been added since the bank was created or reset, and a bin
+ * added later starts from the samples that arrive after it.
+ *
+ * @param bin The FFT bin, 1 to WINDOW_SIZE / 2 - 1.
+ * @return The index of the bin for getMagnitude, or -1 if the bin is out of
+ * range or the bank would need more than SLIDING_DFT_BINS bins.
+ */
+int SlidingDFT::addBin(int bin)
+{
+    if (bin < 1 || bin >= WINDOW_SIZE / 2) {
+        Serial.printf("Error: bin %d can not be tracked.\n", bin);
+        return -1;
+    }
+    for (int i = 0; i < numBins; i++) {
+        if (bins[i] == bin) {
+            return i;
+        }
+    }
+    if (numBins == SLIDING_DFT_BINS) {
+        Serial.printf("Error: already tracking %d bins.\n", SLIDING_DFT_BINS);
+        return -1;
+    }
+
+    int i     = numBins++;
+    bins[i]   = bin;
+    lower[i]  = bin > 1 ? getResonator(bin - 1) : -1;
+    center[i] = getResonator(bin);
+    upper[i]  = getResonator(bin + 1);
+    return i;
+}
+
+/**
+ * Starts tracking the bin closest to a frequency, see addBin.
+ *
+ * @param freq Frequency in Hz.
+ * @return The index of the bin for getMagnitude, or -1.
+ */
+int SlidingDFT::addFrequency(float freq)
+{
+    return addBin((int)roundf(freq * WINDOW_SIZE / SAMPLE_RATE));
+}
+
+/**
+ * Returns the resonator of a bin, adding a new one if no tracked bin uses it
+ * yet.
+ *
+ * @param bin The FFT bin.
+ * @return int
+ */
+int SlidingDFT::getResonator(int bin)
+{
+    for (int r = 0; r < numResonators; r++) {
+        if (resonatorBin[r] == bin) {
+            return r;
+        }
+    }
+
+    int   r     = numResonators++;
+    float angle = 2 * PI * bin / WINDOW_SIZE;
+    resonatorBin[r] = bin;
+    rotRe[r]        = cosf(angle);
+    rotIm[r]        = sinf(angle);
+    stateRe[r]      = 0.0f;
+    stateIm[r]      = 0.0f;
+
+    // e^(i * angle) * (1 - d^N) / (1 - d * e^(i * angle)), the damped sum of
+    // the rotations a constant goes through while it is in the window
+    float denRe = 1.0f - SLIDING_DFT_DAMPING * rotRe[r];
+    float denIm = -SLIDING_DFT_DAMPING * rotIm[r];
+    float scale = (1.0f - dampingN) / (denRe * denRe + denIm * denIm);
+    float qRe   = denRe * scale;
+    float qIm   = -denIm * scale;
+    leakRe[r]   = rotRe[r] * qRe - rotIm[r] * qIm;
+    leakIm[r]   = rotRe[r] * qIm + rotIm[r] * qRe;
+    return r;
+}
+
+/**
+ * Stops tracking all bins and clears the sample history.
+ */
+void SlidingDFT::clear()
+{
+    numBins       = 0;
+    numResonators = 0;
+    reset();
+}
+
+/**
+ * Clears the sample history and the resonators, keeping the tracked bins.
+ */
+void SlidingDFT::reset()
+{
+    for (int i = 0; i < WINDOW_SIZE; i++) {
+        samples[i] = 0.0f;
+    }
+    for (int r = 0; r < numResonators; r++) {
+        stateRe[r] = 0.0f;
+        stateIm[r] = 0.0f;
+    }
+    position = 0;
+    sum      = 0.0f;
+}
+
+/**
+ * Slides the window by one sample: the oldest sample is removed from every
+ * resonator, the new one added, and each resonator rotated by its bin's
+ * frequency, so its state stays the DFT of the last WINDOW_SIZE samples.
+ *
+ * @param sample The new sample.
+ */
+void SlidingDFT::update(float sample)
+{
+    float delta       = sample - dampingN * samples[position];
+    sum              += sample - samples[position];
+    samples[position] = sample;
+    position          = position == WINDOW_SIZE - 1 ? 0 : position + 1;
+
+    // resum once per window so rounding errors do not pile up in the sum
+    if (position == 0) {
+        sum = 0.0f;
+        for (int i = 0; i < WINDOW_SIZE; i++) {
+            sum += samples[i];
+        }
+    }
+
+    for (int r = 0; r < numResonators; r++) {
+        float re   = stateRe[r] * SLIDING_DFT_DAMPING + delta;
+        float im   = stateIm[r] * SLIDING_DFT_DAMPING;
+        stateRe[r] = re * rotRe[r] - im * rotIm[r];
+        stateIm[r] = re * rotIm[r] + im * rotRe[r];
+    }
+}
+
+/**
+ * Slides the window by a number of samples, see update(float).
+ *
+ * @param samples The new samples, oldest first.
+ * @param numSamples Number of samples.
+ */
+void SlidingDFT::update(const float* samples, int numSamples)
+{
+    for (int i = 0; i < numSamples; i++) {
+        update(samples[i]);
+    }
+}
+
+/**
+ * Returns the number of tracked bins.
+ *
+ * @return int
+ */
+int SlidingDFT::getNumBins()
+{
+    return numBins;
+}
+
+/**
+ * Returns the FFT bin tracked at an index.
+ *
+ * @return int
+ */
+int SlidingDFT::getBin(int index)
+{
+    return bins[index];
+}
+
+/**
+ * Returns the center frequency in Hz of the bin tracked at an index.
+ *
+ * @return float
+ */
+float SlidingDFT::getFrequency(int index)
+{
+    return (float)bins[index] * SAMPLE_RATE / WINDOW_SIZE;
+}
+
+/**
+ * Returns the magnitude of the bin tracked at an index over the last
+ * WINDOW_SIZE samples, Hamming windowed as 0.54 of the bin minus 0.23 of
+ * each neighbour.
+ *
+ * @param index The index returned by addBin.
+ * @return float
+ */
+float SlidingDFT::getMagnitude(int index)
+{
+    // the mean, which is all DC, only shows up in the resonators through
+    // the damping, so it is removed with each one's leak
+    float mean = sum / WINDOW_SIZE;
+    int   c    = center[index];
+    int   u    = upper[index];
+    int   l    = lower[index];
+    float re   = 0.54f * (stateRe[c] - mean * leakRe[c]) - 0.23f * (stateRe[u] - mean * leakRe[u]);
+    float im   = 0.54f * (stateIm[c] - mean * leakIm[c]) - 0.23f * (stateIm[u] - mean * leakIm[u]);
+    if (l >= 0) {
+        re -= 0.23f * (stateRe[l] - mean * leakRe[l]);
+        im -= 0.23f * (stateIm[l] - mean * leakIm[l]);
+    }
+    return sqrtf(re * re + im * im);
+}
+
+/**
+ * Writes the magnitudes of all tracked bins into output, in the order they
+ * were added.
+ *
+ * @param output Array of at least getNumBins() magnitudes.
+ */
+void SlidingDFT::getMagnitudes(float* output)
+{
+    for (int i = 0; i < numBins; i++) {
+        output[i] = getMagnitude(i);
+    }
+}
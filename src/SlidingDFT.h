@@ -0,0 +1,107 @@
+/**
+ * @file
+ * Contains the declaration of the SlidingDFT class.
+*/
+
+#ifndef SlidingDFT_h
+#define SlidingDFT_h
+
+#include <AudioLab.h>
+
+#ifndef SLIDING_DFT_BINS
+//! Maximum number of bins a SlidingDFT can track.
+#define SLIDING_DFT_BINS 16
+#endif
+
+#ifndef SLIDING_DFT_DAMPING
+//! Per sample damping of the resonators, which keeps rounding errors from
+//! accumulating. The oldest sample of the window is weighted by
+//! SLIDING_DFT_DAMPING ^ (WINDOW_SIZE - 1).
+#define SLIDING_DFT_DAMPING 0.99999f
+#endif
+
+/**
+ * A bank of resonators that keeps the DFT of the last WINDOW_SIZE samples up
+ * to date for a chosen set of bins, one sample at a time.
+ *
+ * Every sample costs a complex multiply-add per resonator instead of a full
+ * FFT per window, so when only a few bins matter the magnitudes are both
+ * cheaper and available after any sample. Each tracked bin k reads the
+ * resonators of k - 1, k and k + 1 to apply a Hamming window in the
+ * frequency domain, and neighbouring tracked bins share resonators. The
+ * window's mean is removed like processAudioInput does, so the magnitudes
+ * follow those of processAudioInput to within the difference between the
+ * periodic Hamming window used here and its symmetric one.
+ */
+class SlidingDFT {
+private:
+  //! Number of tracked bins
+  int numBins;
+  //! Number of resonators, at most three per tracked bin
+  int numResonators;
+
+  // tracked bins, and the resonators of k - 1, k and k + 1 (-1 for DC)
+  int bins[SLIDING_DFT_BINS];
+  int lower[SLIDING_DFT_BINS];
+  int center[SLIDING_DFT_BINS];
+  int upper[SLIDING_DFT_BINS];
+
+  // resonators, rotated by e^(2 * PI * i * k / WINDOW_SIZE) every sample
+  int   resonatorBin[3 * SLIDING_DFT_BINS];
+  float rotRe[3 * SLIDING_DFT_BINS];
+  float rotIm[3 * SLIDING_DFT_BINS];
+  float stateRe[3 * SLIDING_DFT_BINS];
+  float stateIm[3 * SLIDING_DFT_BINS];
+  // what a constant of 1 leaves in each resonator due to the damping
+  float leakRe[3 * SLIDING_DFT_BINS];
+  float leakIm[3 * SLIDING_DFT_BINS];
+
+  //! The last WINDOW_SIZE samples, needed to remove each one as it leaves
+  float samples[WINDOW_SIZE];
+  //! Index of the oldest sample in samples
+  int position;
+  //! Sum of samples, for removing the window's mean like processAudioInput
+  float sum;
+  //! SLIDING_DFT_DAMPING ^ WINDOW_SIZE
+  float dampingN;
+
+  //! Returns the resonator of bin, adding it if needed.
+  int getResonator(int bin);
+public:
+  //! Default constructor.
+  SlidingDFT();
+
+  //! Starts tracking a bin, returning its index in the bank.
+  int addBin(int bin);
+
+  //! Starts tracking the bin closest to a frequency in Hz.
+  int addFrequency(float freq);
+
+  //! Stops tracking all bins and clears the sample history.
+  void clear();
+
+  //! Forgets the sample history, keeping the tracked bins.
+  void reset();
+
+  //! Slides the window by one sample.
+  void update(float sample);
+
+  //! Slides the window by a number of samples.
+  void update(const float* samples, int numSamples);
+
+  //! Returns the number of tracked bins.
+  int getNumBins();
+
+  //! Returns the FFT bin tracked at an index.
+  int getBin(int index);
+
+  //! Returns the frequency in Hz of the bin tracked at an index.
+  float getFrequency(int index);
+
+  //! Returns the windowed magnitude of the bin tracked at an index.
+  float getMagnitude(int index);
+
+  //! Writes the magnitudes of all tracked bins into output.
+  void getMagnitudes(float* output);
+};
+#endif
@@ -0,0 +1,131 @@
+/**
+ * @file
+ * Contains the SpectrumRing class template, a lock-free single producer,
+ * single consumer ring of spectrum frames.
+*/
+
+#ifndef SpectrumRing_h
+#define SpectrumRing_h
+
+#include <atomic>
+#include <stdint.h>
+
+/**
+ * A fixed ring of DEPTH frames of LENGTH floats, handed from one producer to
+ * one consumer without locks or copies.
+ *
+ * The producer asks for the next free frame with beginWrite, fills it in
+ * place, and publishes it with commitWrite. The consumer takes the oldest
+ * published frame with beginRead, uses it in place, and returns it with
+ * endRead. Each side only writes its own counter, with release ordering, and
+ * reads the other side's with acquire ordering, so producer and consumer may
+ * run on different cores or threads.
+ *
+ * The HISTORY most recently returned frames are not reused by the producer,
+ * so the consumer can keep looking at them through getHistory, like the
+ * windows of a Spectrogram, without copying them anywhere. At most
+ * DEPTH - HISTORY frames are in flight between the two sides.
+ */
+template <int LENGTH, int DEPTH, int HISTORY = 0>
+class SpectrumRing {
+  static_assert(DEPTH > HISTORY, "SpectrumRing needs more frames than it keeps as history");
+
+private:
+  float frames[DEPTH][LENGTH];
+  //! Number of frames ever published, written by the producer only
+  std::atomic<uint32_t> writeCount;
+  //! Number of frames ever returned, written by the consumer only
+  std::atomic<uint32_t> readCount;
+public:
+  SpectrumRing() : writeCount(0), readCount(0) {}
+
+  //! Frames belong to one producer and one consumer, so a copy starts empty.
+  SpectrumRing(const SpectrumRing&) : writeCount(0), readCount(0) {}
+
+  /**
+   * Returns the next frame to fill, or nullptr if every frame is still
+   * waiting to be read. Producer only.
+   *
+   * @return float*
+   */
+  float* beginWrite()
+  {
+      uint32_t w    = writeCount.load(std::memory_order_relaxed);
+      uint32_t r    = readCount.load(std::memory_order_acquire);
+      uint32_t kept = r < (uint32_t)HISTORY ? r : HISTORY;
+      if (w - r + kept >= DEPTH) {
+          return nullptr;
+      }
+      return frames[w % DEPTH];
+  }
+
+  /**
+   * Publishes the frame returned by beginWrite to the consumer. Producer
+   * only.
+   */
+  void commitWrite()
+  {
+      writeCount.store(writeCount.load(std::memory_order_relaxed) + 1, std::memory_order_release);
+  }
+
+  /**
+   * Returns the oldest published frame, or nullptr if there is none.
+   * Consumer only.
+   *
+   * @return float*
+   */
+  float* beginRead()
+  {
+      uint32_t r = readCount.load(std::memory_order_relaxed);
+      if (writeCount.load(std::memory_order_acquire) == r) {
+          return nullptr;
+      }
+      return frames[r % DEPTH];
+  }
+
+  /**
+   * Returns the frame from beginRead to the producer. Consumer only.
+   */
+  void endRead()
+  {
+      readCount.store(readCount.load(std::memory_order_relaxed) + 1, std::memory_order_release);
+  }
+
+  /**
+   * Returns one of the HISTORY most recently returned frames. Consumer only.
+   *
+   * @param age 0 for the frame returned last, 1 for the one before, and so
+   * on.
+   * @return The frame, or nullptr if age is not below HISTORY or that many
+   * frames have not been returned yet.
+   */
+  const float* getHistory(int age)
+  {
+      uint32_t r = readCount.load(std::memory_order_relaxed);
+      if (age < 0 || age >= HISTORY || (uint32_t)age >= r) {
+          return nullptr;
+      }
+      return frames[(r - 1 - age) % DEPTH];
+  }
+
+  /**
+   * Returns the number of published frames not yet returned.
+   *
+   * @return int
+   */
+  int size()
+  {
+      return writeCount.load(std::memory_order_acquire) - readCount.load(std::memory_order_acquire);
+  }
+
+  /**
+   * Empties the ring. Only safe while neither side is using it.
+   */
+  void clear()
+  {
+      writeCount.store(0, std::memory_order_relaxed);
+      readCount.store(0, std::memory_order_relaxed);
+  }
+};
+
+#endif
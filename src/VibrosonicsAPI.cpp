@@ -10,29 +10,239 @@
 void VibrosonicsAPI::init()
 {
     AudioLab.init();
-    this->computeHammingWindow();
+#ifdef VIBROSONICS_FIXED_POINT
+    fixedPipeline.init();
+#endif
 }
 
 /**
- * Feeds its input array to the Fast4ier fourier transform engine
- * and stores the results in private data members vData and vReal.
+ * Feeds the AudioLab input buffer to the Fast4ier fourier transform engine
+ * and writes the frequency magnitudes to the output array.
  *
- * @param output Array of signals to store result of FFT operations in.
+ * The front end is fused: DC removal, windowing and packing for the
+ * real-input FFT happen in a single pass over the samples, and magnitudes are
+ * computed during the split post-pass straight into the output. Since the
+ * input samples are purely real, only the WINDOW_SIZE_BY_2 non-redundant
+ * frequency bins are computed.
+ *
+ * @param output Array of WINDOW_SIZE_BY_2 signals to store result of FFT
+ * operations in.
  */
 void VibrosonicsAPI::processAudioInput(float output[])
 {
-    // Use Fast4ier combined with Vibrosonics FFT functions
-    dcRemoval();
-    fftWindowing();
-    Fast4::FFT(vData, WINDOW_SIZE);
-    complexToMagnitude();
+    VIBROSONICS_PROFILE_SCOPE(profiler, "processAudioInput");
+    runFrontEnd(output);
+}
+
+/**
+ * Computes the frequency magnitudes of the AudioLab input buffer like
+ * processAudioInput(float*), but straight into the next frame of the API's
+ * spectrum history instead of a sketch-owned array, so no copy of the
+ * spectrum is needed to keep it around. The frame may be changed in place
+ * and stays valid for the next SPECTRUM_HISTORY windows, see getSpectrum.
+ *
+ * @return WINDOW_SIZE_BY_2 magnitudes, or nullptr in pipelined mode, where
+ * acquireSpectrum hands out the spectra.
+ */
+float* VibrosonicsAPI::processAudioInput()
+{
+    VIBROSONICS_PROFILE_SCOPE(profiler, "processAudioInput");
+
+    float* frame = isPipelined() ? nullptr : spectrumRing.beginWrite();
+    if (!frame) {
+        Serial.printf("Error: no free spectrum frame, use acquireSpectrum in pipelined mode.\n");
+        return nullptr;
+    }
+    runFrontEnd(frame);
+    spectrumRing.commitWrite();
+
+    // produced and consumed at once, the frame goes straight into the history
+    spectrumRing.beginRead();
+    spectrumRing.endRead();
+    return frame;
+}
+
+/**
+ * Returns one of the last SPECTRUM_HISTORY spectra computed by
+ * processAudioInput() or released with releaseSpectrum, without copying it.
+ *
+ * @param age 0 for the newest spectrum, 1 for the one before, and so on.
+ * @return WINDOW_SIZE_BY_2 magnitudes, or nullptr if age is not below
+ * SPECTRUM_HISTORY or there have not been that many windows yet.
+ */
+const float* VibrosonicsAPI::getSpectrum(int age)
+{
+    return spectrumRing.getHistory(age);
+}
+
+/**
+ * Computes the magnitudes of the window captured by captureWindow, see
+ * processAudioInput. Shared by processAudioInput and the pipelined front end.
+ *
+ * @param output Array of WINDOW_SIZE_BY_2 magnitudes.
+ */
+void VibrosonicsAPI::runFrontEnd(float* output)
+{
+    // consume the hop first, every front end transforms exactly one
+    if (pendingHops > 0) {
+        pendingHops--;
+    }
+
+#ifdef VIBROSONICS_FIXED_POINT
+    // the fixed-point chain owns the samples, convert its magnitudes
+    fixedPipeline.processSamples(adcSamples, fixedData);
+    fixedToFloat(fixedData, output, WINDOW_SIZE_BY_2);
+#else
+#ifdef VIBROSONICS_OVERLAP
+    if (hopSize < WINDOW_SIZE) {
+        packHop();
+    } else
+#endif
+    {
+        // mean of the window for DC removal
+        float sum = 0.0f;
+        for (int i = 0; i < WINDOW_SIZE; i++) {
+            sum += vData[i].re();
+        }
+        float mean = sum / WINDOW_SIZE;
+
+        // remove DC, apply the hamming window and pack sample pairs in one pass
+        const float* hamming = Tables::hamming();
+        for (int i = 0; i < WINDOW_SIZE_BY_2; i++) {
+            float even = (vData[2 * i].re() - mean) * hamming[2 * i];
+            float odd  = (vData[2 * i + 1].re() - mean) * hamming[2 * i + 1];
+            vData[i]   = complex(even, odd);
+        }
+    }
 
-    // Copy complex data to float arrays
+    Fast4::FFT(vData, WINDOW_SIZE_BY_2);
+
+    // split the packed spectrum, writing only magnitudes unless the complex
+    // bins are kept for PEAK_PHASE_VOCODER
+    float* re = nullptr;
+    float* im = nullptr;
+#ifndef VIBROSONICS_LOW_MEMORY
+    if (keepBins) {
+        binFrame     = 1 - binFrame;
+        numBinFrames = numBinFrames < 2 ? numBinFrames + 1 : 2;
+        re           = binRe[binFrame];
+        im           = binIm[binFrame];
+    }
+#endif
+    float zr  = vData[0].re();
+    float zi  = vData[0].im();
+    output[0] = fabsf(zr + zi);
+    for (int k = 1; k <= WINDOW_SIZE_BY_4; k++) {
+        int   m = WINDOW_SIZE_BY_2 - k;
+        float evenRe, evenIm, rotRe, rotIm;
+        splitBins(k, evenRe, evenIm, rotRe, rotIm);
+
+        float loRe = evenRe + rotRe;
+        float loIm = evenIm + rotIm;
+        float hiRe = evenRe - rotRe;
+        float hiIm = rotIm - evenIm;
+        output[m]  = sqrtf(hiRe * hiRe + hiIm * hiIm);
+        output[k]  = sqrtf(loRe * loRe + loIm * loIm);
+        if (re) {
+            re[k] = loRe;
+            im[k] = loIm;
+            re[m] = hiRe;
+            im[m] = hiIm;
+        }
+    }
+#endif
+}
+
+#ifdef VIBROSONICS_OVERLAP
+/**
+ * Fills vData like the fused pass of runFrontEnd, but from the WINDOW_SIZE
+ * samples of the sample history that end at the hop runFrontEnd just took,
+ * pendingHops hops before the end of the captured window. The window may
+ * wrap around the end of the history, which is why it is read through a
+ * mask instead of a plain offset.
+ */
+void VibrosonicsAPI::packHop()
+{
+    const int mask  = 2 * WINDOW_SIZE - 1;
+    int       lag   = pendingHops * hopSize;
+    int       start = (historyEnd + WINDOW_SIZE - lag) & mask;
+
+    float sum = 0.0f;
     for (int i = 0; i < WINDOW_SIZE; i++) {
-        vReal[i]  = vData[i].re();
-        output[i] = vReal[i];
+        sum += sampleHistory[(start + i) & mask];
+    }
+    float mean = sum / WINDOW_SIZE;
+
+    const float* hamming = Tables::hamming();
+    for (int i = 0; i < WINDOW_SIZE_BY_2; i++) {
+        float even = (sampleHistory[(start + 2 * i) & mask] - mean) * hamming[2 * i];
+        float odd  = (sampleHistory[(start + 2 * i + 1) & mask] - mean) * hamming[2 * i + 1];
+        vData[i]   = complex(even, odd);
     }
 }
+#endif
+
+/**
+ * Sets the number of samples between consecutive spectra. With a hop below
+ * WINDOW_SIZE the windows overlap: every captured window then holds
+ * WINDOW_SIZE / hopSize hops, and each call to processAudioInput transforms
+ * the WINDOW_SIZE samples ending at the oldest hop not yet transformed, read
+ * from a history of the last two captured windows. Sketches loop over
+ * getPendingHops after isAudioLabReady to get a spectrum every hop, e.g. a
+ * hop of WINDOW_SIZE_BY_2 for 50% or WINDOW_SIZE_BY_4 for 75% overlap.
+ *
+ * AudioLab still delivers a whole window at a time, so the hops of a window
+ * are all available once it is captured; overlap gives a finer time grid for
+ * onsets, not an earlier first spectrum. Not available with
+ * VIBROSONICS_FIXED_POINT or VIBROSONICS_LOW_MEMORY, which keep no sample
+ * history, and not while pipelined.
+ *
+ * @param hopSize Samples between spectra, a divisor of WINDOW_SIZE. Pass
+ * WINDOW_SIZE to turn overlap off.
+ * @return false if the hop size was not changed.
+ */
+bool VibrosonicsAPI::setHopSize(int hopSize)
+{
+#ifndef VIBROSONICS_OVERLAP
+    if (hopSize != WINDOW_SIZE) {
+        Serial.printf("Error: overlapping windows are not available in fixed-point or low memory builds.\n");
+        return false;
+    }
+#endif
+    if (hopSize <= 0 || hopSize > WINDOW_SIZE || WINDOW_SIZE % hopSize != 0) {
+        Serial.printf("Error: hop size %d does not divide WINDOW_SIZE.\n", hopSize);
+        return false;
+    }
+    if (isPipelined()) {
+        Serial.printf("Error: stop the pipeline before changing the hop size.\n");
+        return false;
+    }
+    this->hopSize = hopSize;
+    pendingHops   = 0;
+    return true;
+}
+
+/**
+ * Returns the number of samples between consecutive spectra, see setHopSize.
+ *
+ * @return int
+ */
+int VibrosonicsAPI::getHopSize()
+{
+    return hopSize;
+}
+
+/**
+ * Returns the number of hops of the last captured window that
+ * processAudioInput has not transformed yet. This is WINDOW_SIZE / hopSize
+ * right after isAudioLabReady returns true, and 0 once they are all done.
+ *
+ * @return int
+ */
+int VibrosonicsAPI::getPendingHops()
+{
+    return pendingHops;
+}
 
 /**
  * Removes the mean of the data from each bin to reduce noise.
@@ -45,12 +255,21 @@ void VibrosonicsAPI::dcRemoval()
     }
 }
 
+/**
+ * Kept for sketches that call it. The hamming window is generated at compile
+ * time for WINDOW_SIZE, see WindowTables, so there is nothing to compute.
+ */
 void VibrosonicsAPI::computeHammingWindow()
 {
-    float step = 2 * PI / (WINDOW_SIZE - 1);
-    for (int i = 0; i < WINDOW_SIZE; i++) {
-        hamming[i] = 0.54 - 0.46 * cos(step * i);
-    }
+}
+
+/**
+ * Kept for sketches that call it. The twiddle factors used to split the
+ * packed half-size transform in realFFT are generated at compile time for
+ * WINDOW_SIZE, see WindowTables, so there is nothing to compute.
+ */
+void VibrosonicsAPI::computeTwiddleFactors()
+{
 }
 
 /**
@@ -61,17 +280,84 @@ void VibrosonicsAPI::fftWindowing()
 {
     for (int i = 0; i < WINDOW_SIZE; i++) {
         // Use precomputed hamming window for better efficiency. Thanks Nick!
-        vData[i] *= hamming[i];
+        vData[i] *= Tables::hamming()[i];
+    }
+}
+
+/**
+ * Computes the FFT of the real samples stored in vData using a half-size
+ * complex transform. Even samples are packed into the real parts and odd
+ * samples into the imaginary parts of the first WINDOW_SIZE_BY_2 entries,
+ * transformed, and then split into the spectrum of the real signal.
+ *
+ * Afterwards vData[0] through vData[WINDOW_SIZE_BY_2] hold the same bins a
+ * full WINDOW_SIZE complex FFT would produce; the remaining entries are
+ * left unspecified.
+ */
+void VibrosonicsAPI::realFFT()
+{
+    // pack sample pairs, reading ahead of the write index so nothing is lost
+    for (int i = 0; i < WINDOW_SIZE_BY_2; i++) {
+        vData[i] = complex(vData[2 * i].re(), vData[2 * i + 1].re());
+    }
+
+    Fast4::FFT(vData, WINDOW_SIZE_BY_2);
+
+    // DC and Nyquist bins are purely real
+    float zr = vData[0].re();
+    float zi = vData[0].im();
+    vData[0]                = complex(zr + zi, 0.0f);
+    vData[WINDOW_SIZE_BY_2] = complex(zr - zi, 0.0f);
+
+    // split bins k and WINDOW_SIZE_BY_2 - k together, in place
+    for (int k = 1; k <= WINDOW_SIZE_BY_4; k++) {
+        int   m = WINDOW_SIZE_BY_2 - k;
+        float evenRe, evenIm, rotRe, rotIm;
+        splitBins(k, evenRe, evenIm, rotRe, rotIm);
+
+        vData[m] = complex(evenRe - rotRe, rotIm - evenIm);
+        vData[k] = complex(evenRe + rotRe, evenIm + rotIm);
     }
 }
 
+/**
+ * Computes the even and rotated odd sample spectra for bin k from the packed
+ * half-size transform in vData. Bin k of the real signal's spectrum is
+ * even + rotated, and bin WINDOW_SIZE_BY_2 - k is the conjugate of
+ * even - rotated.
+ *
+ * @param k The bin to split, between 1 and WINDOW_SIZE_BY_4.
+ */
+void VibrosonicsAPI::splitBins(int k, float& evenRe, float& evenIm,
+    float& rotRe, float& rotIm)
+{
+    int   m  = WINDOW_SIZE_BY_2 - k;
+    float ar = vData[k].re();
+    float ai = vData[k].im();
+    float br = vData[m].re();
+    float bi = -vData[m].im();
+
+    evenRe      = 0.5f * (ar + br);
+    evenIm      = 0.5f * (ai + bi);
+    float oddRe = 0.5f * (ai - bi);
+    float oddIm = -0.5f * (ar - br);
+
+    // rotate the odd spectrum by exp(-2 * PI * i * k / WINDOW_SIZE)
+    float c = Tables::twiddleCos()[k];
+    float s = Tables::twiddleSin()[k];
+    rotRe   = c * oddRe + s * oddIm;
+    rotIm   = c * oddIm - s * oddRe;
+}
+
 /**
  * Converts raw FFT output to a readable frequency spectrogram.
  */
 void VibrosonicsAPI::complexToMagnitude()
 {
-    for (int i = 0; i < WINDOW_SIZE; i++) {
-        vData[i] = sqrt(pow(vData[i].re(), 2) + pow(vData[i].im(), 2));
+    for (int i = 0; i <= WINDOW_SIZE_BY_2; i++) {
+        float re = vData[i].re();
+        float im = vData[i].im();
+        vData[i] = sqrtf(re * re + im * im);
     }
 }
 
@@ -83,10 +369,7 @@ void VibrosonicsAPI::complexToMagnitude()
  */
 float VibrosonicsAPI::getMean(float* data, int dataLength)
 {
-    float sum = 0.0;
-    for (int i = 0; i < dataLength; i++) {
-        sum += data[i];
-    }
+    float sum = Kernels::sum(data, dataLength);
     return sum > 0.0 ? sum / dataLength : sum;
 }
 
@@ -113,11 +396,9 @@ float VibrosonicsAPI::getMean(complex* data, int dataLength)
  */
 void VibrosonicsAPI::noiseFloor(float* ampData, float threshold)
 {
-    for (int i = 0; i < WINDOW_SIZE_BY_2; i++) {
-        if (ampData[i] < threshold) {
-            ampData[i] = 0.0;
-        }
-    }
+    VIBROSONICS_PROFILE_SCOPE(profiler, "noiseFloor");
+
+    Kernels::threshold(ampData, threshold, ampData, WINDOW_SIZE_BY_2);
 }
 
 /**
@@ -135,91 +416,454 @@ void VibrosonicsAPI::noiseFloor(float* ampData, float threshold)
  */
 void VibrosonicsAPI::noiseFloorCFAR(float* windowData, int numRefs, int numGuards, float bias)
 {
-    int   i, j, numCells;
-    int   left_start, left_end, right_start, right_end;
+    noiseFloorCFAR(windowData, windowData, numRefs, numGuards, bias, CA_CFAR);
+}
+
+/**
+ * Estimates the noise level around each cell under test (CUT) from the
+ * reference cells on either side of it, skipping the guard cells next to the
+ * CUT. If the CUT's value is not greater than the noise level * a bias, it is
+ * floored in the output, otherwise it is copied.
+ *
+ * The cell averaging variants (CA, GO and SO) sum the reference cells using
+ * prefix sums of the input, so they run in O(WINDOW_SIZE_BY_2) time
+ * regardless of numRefs, and input and output may be the same array. Only
+ * the cells near the edges clamp their reference windows; the interior loop
+ * runs without bounds checks.
+ *
+ * OS-CFAR keeps the reference cells sorted as the window slides, and uses the
+ * cell at OS_CFAR_RANK as the noise level. It is more robust to neighbouring
+ * peaks but costs O(numRefs) per cell, and requires separate input and output
+ * arrays.
+ *
+ * Read more on the CFAR here:
+ * https://en.wikipedia.org/wiki/Constant_false_alarm_rate.
+ *
+ * @param input The frequency domain data to filter.
+ * @param output The array to write the filtered data to.
+ * @param numRefs The number of reference cells on each side of the CUT.
+ * @param numGuards The number of guard cells for CFAR.
+ * @param bias The bias factor to use for CFAR.
+ * @param type The method used to estimate the noise level.
+ *
+ * Under load, numRefs may be lowered by the degradation policy, see
+ * setDegradationPolicy.
+ */
+void VibrosonicsAPI::noiseFloorCFAR(const float* input, float* output, int numRefs,
+    int numGuards, float bias, CFARType type)
+{
+    VIBROSONICS_PROFILE_SCOPE(profiler, "noiseFloorCFAR");
+    numRefs = deadlineMonitor.limitCFARRefs(numRefs);
+
+    if (type == OS_CFAR) {
+        if (input == output) {
+            Serial.printf("Error: OS-CFAR requires separate input and output arrays.\n");
+            return;
+        }
+        noiseFloorOSCFAR(input, output, numRefs, numGuards, bias);
+        return;
+    }
+
+    // prefix sums, so the sum of cells [a, b) is cfarScratch[b] - cfarScratch[a]
+    float* sums = getCFARScratch();
+    sums[0]     = 0.0f;
+    for (int i = 0; i < WINDOW_SIZE_BY_2; i++) {
+        sums[i + 1] = sums[i] + input[i];
+    }
+
+    // only the numGuards + numRefs cells at either edge have reference
+    // windows that need clamping to the spectrum, the interior has numRefs
+    // cells on both sides
+    int edge     = numRefs > 0 ? min(WINDOW_SIZE_BY_2, numGuards + numRefs) : WINDOW_SIZE_BY_2;
+    int interior = max(edge, WINDOW_SIZE_BY_2 - edge);
+
+    for (int i = 0; i < edge; i++) {
+        noiseFloorCFARCell(input, output, i, numRefs, numGuards, bias, type);
+    }
+
+    const float numCells = 2 * numRefs;
+    for (int i = edge; i < interior; i++) {
+        float leftSum  = sums[i - numGuards] - sums[i - numGuards - numRefs];
+        float rightSum = sums[i + numGuards + numRefs] - sums[i + numGuards];
+
+        float noiseLevel;
+        if (type == CA_CFAR) {
+            noiseLevel = (leftSum + rightSum) / numCells;
+        } else {
+            float leftMean  = leftSum / numRefs;
+            float rightMean = rightSum / numRefs;
+            noiseLevel      = type == GO_CFAR ? max(leftMean, rightMean) : min(leftMean, rightMean);
+        }
+
+        // copy original data if above noiseLevel, otherwise floor the CUT
+        float cut = input[i];
+        output[i] = cut > noiseLevel * bias ? cut : 0.0f;
+    }
+
+    for (int i = interior; i < WINDOW_SIZE_BY_2; i++) {
+        noiseFloorCFARCell(input, output, i, numRefs, numGuards, bias, type);
+    }
+}
+
+/**
+ * Floors one cell of a cell averaging CFAR, clamping its reference windows to
+ * the spectrum. Used for the cells near the edges, reading the prefix sums
+ * noiseFloorCFAR left in the CFAR scratch.
+ *
+ * @param input The frequency domain data to filter.
+ * @param output The array to write the filtered data to.
+ * @param i The cell under test.
+ * @param numRefs The number of reference cells on each side of the CUT.
+ * @param numGuards The number of guard cells for CFAR.
+ * @param bias The bias factor to use for CFAR.
+ * @param type CA_CFAR, GO_CFAR or SO_CFAR.
+ */
+void VibrosonicsAPI::noiseFloorCFARCell(const float* input, float* output, int i, int numRefs,
+    int numGuards, float bias, CFARType type)
+{
+    const float* sums = getCFARScratch();
+
+    // calculate bounds for cell under test (CUT)
+    int left_start  = max(0, i - numGuards - numRefs);
+    int left_end    = max(0, i - numGuards);
+    int right_start = min(WINDOW_SIZE_BY_2, i + numGuards);
+    int right_end   = min(WINDOW_SIZE_BY_2, i + numGuards + numRefs);
+
+    int   numLeft  = left_end - left_start;
+    int   numRight = right_end - right_start;
+    float leftSum  = sums[left_end] - sums[left_start];
+    float rightSum = sums[right_end] - sums[right_start];
+
     float noiseLevel;
+    if (type == CA_CFAR || numLeft == 0 || numRight == 0) {
+        // at the edges GO and SO fall back to the only side available
+        int numCells = numLeft + numRight;
+        noiseLevel   = (leftSum + rightSum) / (numCells > 0 ? numCells : 1);
+    } else {
+        float leftMean  = leftSum / numLeft;
+        float rightMean = rightSum / numRight;
+        noiseLevel      = type == GO_CFAR ? max(leftMean, rightMean) : min(leftMean, rightMean);
+    }
 
-    // copy data for output
-    float dataCopy[WINDOW_SIZE_BY_2];
-    memcpy(dataCopy, windowData, WINDOW_SIZE_BY_2 * sizeof(float));
+    // copy original data if above noiseLevel, otherwise floor the CUT
+    float cut = input[i];
+    output[i] = cut > noiseLevel * bias ? cut : 0.0f;
+}
 
-    for (i = 0; i < WINDOW_SIZE_BY_2; i++) {
-        // calculate bounds for cell under test (CUT)
-        left_start  = max(0, i - numGuards - numRefs);
-        left_end    = max(0, i - numGuards);
-        right_start = min(WINDOW_SIZE_BY_2, i + numGuards);
-        right_end   = min(WINDOW_SIZE_BY_2, i + numGuards + numRefs);
+/**
+ * Order statistic CFAR. The reference cells are kept sorted in the scratch
+ * as the window slides: each step removes the cells that left the window and
+ * inserts the cells that entered it, so the noise level is a direct lookup.
+ *
+ * @param input The frequency domain data to filter.
+ * @param output The array to write the filtered data to, distinct from input.
+ * @param numRefs The number of reference cells on each side of the CUT.
+ * @param numGuards The number of guard cells for CFAR.
+ * @param bias The bias factor to use for CFAR.
+ */
+void VibrosonicsAPI::noiseFloorOSCFAR(const float* input, float* output, int numRefs,
+    int numGuards, float bias)
+{
+    float* sorted   = getCFARScratch();
+    int    numCells = 0;
 
-        numCells   = 0;
-        noiseLevel = 0;
+    // bounds of the previous CUT, all of which only move forward
+    int prevLeftStart  = 0;
+    int prevLeftEnd    = 0;
+    int prevRightStart = min(WINDOW_SIZE_BY_2, numGuards);
+    int prevRightEnd   = prevRightStart;
 
-        // compute sum of cells within bounds
-        for (j = left_start; j < left_end; j++) {
-            noiseLevel += dataCopy[j];
-            numCells++;
+    for (int i = 0; i < WINDOW_SIZE_BY_2; i++) {
+        int left_start  = max(0, i - numGuards - numRefs);
+        int left_end    = max(0, i - numGuards);
+        int right_start = min(WINDOW_SIZE_BY_2, i + numGuards);
+        int right_end   = min(WINDOW_SIZE_BY_2, i + numGuards + numRefs);
+
+        // remove cells that left the reference windows
+        for (int pass = 0; pass < 2; pass++) {
+            int from = pass == 0 ? prevLeftStart : prevRightStart;
+            int to   = pass == 0 ? left_start : right_start;
+            for (int j = from; j < to; j++) {
+                int pos = 0;
+                while (pos < numCells - 1 && sorted[pos] != input[j]) {
+                    pos++;
+                }
+                numCells--;
+                memmove(&sorted[pos], &sorted[pos + 1], (numCells - pos) * sizeof(float));
+            }
         }
-        for (j = right_start; j < right_end; j++) {
-            noiseLevel += dataCopy[j];
-            numCells++;
+
+        // insert cells that entered the reference windows
+        for (int pass = 0; pass < 2; pass++) {
+            int from = pass == 0 ? prevLeftEnd : prevRightEnd;
+            int to   = pass == 0 ? left_end : right_end;
+            for (int j = from; j < to; j++) {
+                int pos = numCells;
+                while (pos > 0 && sorted[pos - 1] > input[j]) {
+                    sorted[pos] = sorted[pos - 1];
+                    pos--;
+                }
+                sorted[pos] = input[j];
+                numCells++;
+            }
         }
 
-        // compute average (noise level) of cells within bounds
-        noiseLevel /= numCells > 0 ? numCells : 1;
+        prevLeftStart  = left_start;
+        prevLeftEnd    = left_end;
+        prevRightStart = right_start;
+        prevRightEnd   = right_end;
 
-        // copy original data if above noiseLevel, otherwise floor the CUT
-        if (dataCopy[i] > noiseLevel * bias) {
-            windowData[i] = dataCopy[i];
-        } else {
-            windowData[i] = 0;
+        float noiseLevel = numCells > 0 ? sorted[(int)(OS_CFAR_RANK * (numCells - 1))] : 0.0f;
+        output[i]        = input[i] > noiseLevel * bias ? input[i] : 0.0f;
+    }
+}
+
+/**
+ * Returns the scratch the CFARs keep their prefix sums or sorted reference
+ * cells in. With VIBROSONICS_LOW_MEMORY it is the front end's vData, which
+ * holds nothing between windows since the spectrum is written out, and
+ * which no other stage uses while the front end runs as there is no
+ * pipelined mode.
+ *
+ * @return WINDOW_SIZE_BY_2 + 1 floats
+ */
+float* VibrosonicsAPI::getCFARScratch()
+{
+#ifdef VIBROSONICS_LOW_MEMORY
+    static_assert(sizeof(vData) >= (WINDOW_SIZE_BY_2 + 1) * sizeof(float), "vData cannot hold the CFAR scratch");
+    return reinterpret_cast<float*>(vData);
+#else
+    return cfarScratch;
+#endif
+}
+
+/**
+ * Refines peaks found at whole bins, such as the frequencies MajorPeaks
+ * outputs, to where they lie between bins, in one pass over the peaks.
+ *
+ * PEAK_PARABOLIC fits a parabola through the magnitudes of the peak bin and
+ * its two neighbours; PEAK_GAUSSIAN fits it through their logarithms, which
+ * suits the main lobe of the Hamming window better and is several times as
+ * accurate. Both also give the amplitude at the top of the parabola.
+ * PEAK_PHASE_VOCODER measures the frequency from how far the bin's phase
+ * advanced since the previous spectrum, independent of the window shape,
+ * and takes the amplitude from the parabola. It needs the complex bins of
+ * the last two spectra, which processAudioInput only keeps from the first
+ * call with PEAK_PHASE_VOCODER on. Until two spectra have been kept it falls
+ * back to PEAK_PARABOLIC, as it does with the fixed-point front end, with
+ * VIBROSONICS_LOW_MEMORY, which keeps no bins, and in pipelined mode, where
+ * the front end runs on another core and keeps no bins either.
+ * processAudioInput must run for every window, or every hop with overlap,
+ * for the phase advance to span a single hop.
+ *
+ * Peaks in the first and last bin, or without a true maximum, keep their
+ * bin's frequency and magnitude; the phase vocoder also leaves the first and
+ * last bin alone.
+ *
+ * @param data WINDOW_SIZE_BY_2 magnitudes the peaks were found in.
+ * @param peakFreqs Frequencies of the peak bins in Hz, e.g.
+ * MajorPeaks::getOutput()[MP_FREQ].
+ * @param freqs Output refined frequencies in Hz. May be peakFreqs.
+ * @param amps Output refined amplitudes, or nullptr.
+ * @param numPeaks Number of peaks.
+ * @param estimator The peakEstimator to use.
+ */
+void VibrosonicsAPI::refinePeaks(const float* data, const float* peakFreqs,
+    float* freqs, float* amps, int numPeaks, peakEstimator estimator)
+{
+    bool usePhase = false;
+#ifndef VIBROSONICS_LOW_MEMORY
+    // the pipelined front end must not share the bins with this core
+    if (estimator == PEAK_PHASE_VOCODER && !isPipelined()) {
+        keepBins = true;
+        usePhase = numBinFrames == 2;
+    }
+#endif
+
+    for (int i = 0; i < numPeaks; i++) {
+        int bin = (int)roundf(peakFreqs[i] * FREQ_WIDTH);
+        if (bin < 0 || bin >= WINDOW_SIZE_BY_2) {
+            freqs[i] = peakFreqs[i];
+            if (amps) {
+                amps[i] = 0.0f;
+            }
+            continue;
         }
+
+        float offset = 0.0f;
+        float amp    = data[bin];
+        if (bin > 0 && bin < WINDOW_SIZE_BY_2 - 1) {
+            float pre    = data[bin - 1];
+            float atPeak = data[bin];
+            float post   = data[bin + 1];
+            bool  useLog = estimator == PEAK_GAUSSIAN && pre > 0.0f && atPeak > 0.0f && post > 0.0f;
+            if (useLog) {
+                pre    = logf(pre);
+                atPeak = logf(atPeak);
+                post   = logf(post);
+            }
+
+            // vertex of the parabola through the three bins
+            float curvature = pre - 2.0f * atPeak + post;
+            if (curvature < 0.0f) {
+                offset = 0.5f * (pre - post) / curvature;
+                offset = offset > 1.0f ? 1.0f : (offset < -1.0f ? -1.0f : offset);
+                amp    = atPeak - 0.25f * (pre - post) * offset;
+                amp    = useLog ? expf(amp) : amp;
+            }
+            if (usePhase) {
+                offset = phaseVocoderOffset(bin);
+            }
+        }
+
+        freqs[i] = (bin + offset) * FREQ_RES;
+        if (amps) {
+            amps[i] = amp;
+        }
+    }
+}
+
+/**
+ * Returns how far a sinusoid in a bin lies from the bin's center, from how
+ * much its phase advanced over the last hop beyond the advance the bin's
+ * center frequency accounts for.
+ *
+ * @param bin The bin, between 1 and WINDOW_SIZE_BY_2 - 2.
+ * @return The offset in bins, within half the number of hops per window.
+ */
+float VibrosonicsAPI::phaseVocoderOffset(int bin)
+{
+#ifdef VIBROSONICS_LOW_MEMORY
+    (void)bin;
+    return 0.0f;
+#else
+    int   prev     = 1 - binFrame;
+    float advance  = atan2f(binIm[binFrame][bin], binRe[binFrame][bin])
+        - atan2f(binIm[prev][bin], binRe[prev][bin]);
+    float expected = 2 * PI * (float)((long)bin * hopSize % WINDOW_SIZE) / WINDOW_SIZE;
+
+    // deviation from the expected advance, wrapped to [-PI, PI]
+    float deviation = advance - expected;
+    deviation -= 2 * PI * roundf(deviation / (2 * PI));
+    return deviation * WINDOW_SIZE / (2 * PI * hopSize);
+#endif
+}
+
+#ifdef VIBROSONICS_FIXED_POINT
+/**
+ * Computes frequency magnitudes from the raw ADC samples using only integer
+ * arithmetic. See FixedPointPipeline for how the magnitudes are scaled.
+ *
+ * @param output Array of WINDOW_SIZE_BY_2 fixed-point magnitudes.
+ */
+void VibrosonicsAPI::processAudioInput(fixed_t* output)
+{
+    VIBROSONICS_PROFILE_SCOPE(profiler, "processAudioInput");
+    if (pendingHops > 0) {
+        pendingHops--;
+    }
+    fixedPipeline.processSamples(adcSamples, output);
+}
+
+/**
+ * Sets the amplitude of a fixed-point bin to 0 if it is less than threshold.
+ *
+ * @param data The fixed-point frequency domain data to filter.
+ * @param threshold The threshold value to floor the data at, see floatToFixed.
+ */
+void VibrosonicsAPI::noiseFloor(fixed_t* data, fixed_t threshold)
+{
+    VIBROSONICS_PROFILE_SCOPE(profiler, "noiseFloor");
+    fixedPipeline.noiseFloor(data, threshold);
+}
+
+/**
+ * Cell averaging CFAR on fixed-point data. Input and output may be the same
+ * array.
+ *
+ * @param input The fixed-point frequency domain data to filter.
+ * @param output The array to write the filtered data to.
+ * @param numRefs The number of reference cells on each side of the CUT.
+ * @param numGuards The number of guard cells for CFAR.
+ * @param bias The bias factor to use for CFAR.
+ */
+void VibrosonicsAPI::noiseFloorCFAR(const fixed_t* input, fixed_t* output, int numRefs,
+    int numGuards, float bias)
+{
+    VIBROSONICS_PROFILE_SCOPE(profiler, "noiseFloorCFAR");
+    numRefs = deadlineMonitor.limitCFARRefs(numRefs);
+    fixedPipeline.noiseFloorCFAR(input, output, numRefs, numGuards, bias);
+}
+
+/**
+ * Converts fixed-point magnitudes to the units of the float path, so they
+ * can be passed on to float analysis and synthesis.
+ *
+ * @param input The fixed-point magnitudes.
+ * @param output The array to write float magnitudes to.
+ * @param dataLength The length of both arrays.
+ */
+void VibrosonicsAPI::fixedToFloat(const fixed_t* input, float* output, int dataLength)
+{
+    float scale = FixedPointPipeline<fixed_t>::magnitudeScale();
+    for (int i = 0; i < dataLength; i++) {
+        output[i] = input[i] * scale;
     }
 }
 
+/**
+ * Converts a magnitude or threshold in the float path's units to fixed-point.
+ *
+ * @param magnitude The magnitude to convert.
+ */
+fixed_t VibrosonicsAPI::floatToFixed(float magnitude)
+{
+    return FixedPointPipeline<fixed_t>::fromFloat(magnitude);
+}
+#endif
+
 /**
  * Maps amplitudes to the range [0, 1] by normalizing them by the sum of
  * the amplitudes. This sum is smoothed by the previous data to ensure a
- * consistent amplitude output and contrast.
+ * consistent amplitude output and contrast. Each stream keeps its own
+ * smoothed sum in the API's AmplitudeNormalizer, so data normalized
+ * separately, such as different bands or channels, should use different
+ * streams. A stream configured through getAmplitudeNormalizer()->setStream
+ * keeps that configuration, and minAmpSum and smoothFactor are ignored for it.
  *
  * @param ampData The amplitude array to map.
  * @param dataLength The length of the amplitude array.
  * @param minAmpSum The minimum value to normalize the amplitudes by (if
  * their sum is not greater than it).
  * @param smoothFactor The factor to smooth the amplitudes by.
+ * @param stream The stream the data belongs to, from 0 to
+ * AMPLITUDE_STREAMS - 1.
  */
 void VibrosonicsAPI::mapAmplitudes(float* ampData, int dataLength,
-    float minAmpSum, float smoothFactor)
+    float minAmpSum, float smoothFactor, int stream)
 {
     if (smoothFactor < 0.0 || smoothFactor > 1.0) {
         Serial.printf("Error: smoothFactor must be between 0 and 1.\n");
         return;
     }
 
-    static float runningSum = minAmpSum;
-
-    // sum amp data
-    float dataSum = 0.0;
-    for (int i = 0; i < dataLength; i++) {
-        dataSum += ampData[i];
-    }
-    if (dataSum == 0.0) {
-        return; // return early if sum of amplitudes is 0
-    }
-
-    // smooth the sum of amplitudes with previous data unless it is greater
-    if (dataSum < runningSum) {
-        runningSum = runningSum * (1 - smoothFactor) + dataSum * smoothFactor;
-        // dampen noise by clamping to minAmpSum
-        if (runningSum < minAmpSum) {
-            runningSum = minAmpSum;
-        }
-    } else {
-        runningSum = dataSum;
+    // louder sums are followed at once, quieter ones smoothed
+    if (!amplitudeNormalizer.setStreamDefaults(stream, minAmpSum, 1.0f, smoothFactor)) {
+        return;
     }
+    amplitudeNormalizer.normalize(stream, ampData, dataLength);
+}
 
-    // convert amplitudes
-    for (int i = 0; i < dataLength; i++) {
-        ampData[i] = (ampData[i] / runningSum);
-    }
+/**
+ * Returns the normalizer behind mapAmplitudes, for attack and release
+ * smoothing and for normalizing several streams in one call. Streams set
+ * with its setStream are no longer changed by mapAmplitudes' arguments.
+ *
+ * @return AmplitudeNormalizer*
+ */
+AmplitudeNormalizer* VibrosonicsAPI::getAmplitudeNormalizer()
+{
+    return &amplitudeNormalizer;
 }
 
 /**
@@ -239,7 +883,8 @@ void VibrosonicsAPI::assignWave(float freq, float amp, int channel)
  * Creates and adds multiple waves to a channel for output. The
  * waves are synthesized from the frequencies and amplitudes provided as
  * arguments. Both frequency and amplitude arrays must be equal lengthed,
- * and their length must be passed as dataLength.
+ * and their length must be passed as dataLength. Waves that round to the
+ * same frequency are created as one, along with any waves already queued.
  *
  * @param freqs Frequencies of the synthesized waves.
  * @param amps Amplitudes of the synthesized waves.
@@ -247,14 +892,84 @@ void VibrosonicsAPI::assignWave(float freq, float amp, int channel)
  * @param channel The output channel to add the waves to.
  */
 void VibrosonicsAPI::assignWaves(float* freqData, float* ampData, int dataLength, int channel)
+{
+    queueWaves(freqData, ampData, dataLength, channel);
+    submitWaves();
+}
+
+/**
+ * Queues a wave for the next submitWaves. A queued wave with the same
+ * channel, frequency and type absorbs its amplitude instead, so each
+ * frequency is created once per channel. VIBROSONICS_LOW_MEMORY keeps no
+ * wave batch, so there the wave is created right away and not merged.
+ *
+ * @param freq Frequency of the synthesized wave.
+ * @param amp Amplitude of the synthesized wave.
+ * @param channel The output channel to add the wave to.
+ * @param type Shape of the synthesized wave.
+ */
+void VibrosonicsAPI::queueWave(float freq, float amp, int channel, WaveType type)
+{
+#ifdef VIBROSONICS_LOW_MEMORY
+    AudioLab.dynamicWave(channel, freq, amp, 0.0, type);
+#else
+    if (!waveBatch.add(channel, freq, amp, 0.0, type)) {
+        Serial.printf("Error: Wave batch of channel %d is full\n", channel);
+    }
+#endif
+}
+
+/**
+ * Queues waves from the values in the frequency and amplitude arrays for the
+ * next submitWaves, like assignWaves does. Frequencies are rounded to whole
+ * Hz, so neighbouring peaks share a wave, and entries with a zero frequency
+ * or amplitude are skipped.
+ *
+ * @param freqs Frequencies of the synthesized waves.
+ * @param amps Amplitudes of the synthesized waves.
+ * @param dataLength The length of the frequency and amplitude arrays.
+ * @param channel The output channel to add the waves to.
+ */
+void VibrosonicsAPI::queueWaves(float* freqData, float* ampData, int dataLength, int channel)
 {
     for (int i = 0; i < dataLength; i++) {
         if (ampData[i] == 0.0 || freqData[i] == 0)
-            continue;                                                              // skip storing if ampData is 0, or freqData is 0
-        Wave wave = AudioLab.dynamicWave(channel, round(freqData[i]), ampData[i]); // create wave
+            continue; // skip storing if ampData is 0, or freqData is 0
+        queueWave(round(freqData[i]), ampData[i], channel);
     }
 }
 
+/**
+ * Creates every queued wave with AudioLab, channel by channel from the
+ * batch's arrays, and empties the batch for the next window.
+ *
+ * @return The number of waves created, always 0 with VIBROSONICS_LOW_MEMORY,
+ * where queueWave creates them.
+ */
+int VibrosonicsAPI::submitWaves()
+{
+#ifdef VIBROSONICS_LOW_MEMORY
+    return 0;
+#else
+    return waveBatch.submit();
+#endif
+}
+
+/**
+ * Returns the batch behind queueWave, submitWaves and updateGrains.
+ *
+ * @return WaveBatch*, or nullptr with VIBROSONICS_LOW_MEMORY, which passed
+ * to GrainBank::update creates the waves directly.
+ */
+WaveBatch* VibrosonicsAPI::getWaveBatch()
+{
+#ifdef VIBROSONICS_LOW_MEMORY
+    return nullptr;
+#else
+    return &waveBatch;
+#endif
+}
+
 float VibrosonicsAPI::mapFrequencyByOctaves(float inFreq, float maxFreq)
 {
     int   shift = 0;
@@ -310,19 +1025,33 @@ Grain* VibrosonicsAPI::createGrainArray(int numGrains, uint8_t channel, WaveType
 }
 
 /**
- * Creates a grain that runs once and is then deleted.
+ * Creates a grain that runs once and is then reaped. Dynamic grains live in
+ * the grain list's fixed pool, so no memory is allocated. If the pool is full
+ * an existing dynamic grain is stolen, see setGrainStealPolicy. Under load
+ * the degradation policy may cap the number of dynamic grains, see
+ * setDegradationPolicy; static grains do not count towards the cap.
  *
  * @param channel The physical speaker channel, on current hardware valid inputs are 0-2
  * @param waveType The type of wave Audiolab will generate utilizing the grains.
  * @param FreqEnv The frequency data used to shape the grain.
  * @param AmpEnv The amplitude data used to shape the grain.
  * @param durEnv The duration lengths and curve to shape the grain.
+ * @return The new grain, or nullptr if the pool is full and nothing could be
+ * stolen, or the degradation policy's grain cap is reached. The pointer is
+ * only valid until the grain is reaped or stolen.
  */
-Grain* VibrosonicsAPI::createDynamicGrain(uint8_t channel, WaveType waveType, FreqEnv freqEnv, AmpEnv ampEnv, DurEnv durEnv)
+Grain* VibrosonicsAPI::createDynamicGrain(uint8_t channel, WaveType waveType,
+    FreqEnv freqEnv, AmpEnv ampEnv, DurEnv durEnv)
 {
-    Grain* newGrain     = new Grain(channel, waveType);
-    newGrain->isDynamic = true;
-    grainList.pushGrain(newGrain);
+    if (!deadlineMonitor.allowsGrain(grainList.getNumDynamicGrains())) {
+        return nullptr;
+    }
+    Grain* newGrain = grainList.allocateGrain();
+    if (!newGrain) {
+        return nullptr;
+    }
+    newGrain->setChannel(channel);
+    newGrain->setWaveType(waveType);
     newGrain->setFreqEnv(freqEnv);
     newGrain->setAmpEnv(ampEnv);
     newGrain->setDurEnv(durEnv);
@@ -330,13 +1059,32 @@ Grain* VibrosonicsAPI::createDynamicGrain(uint8_t channel, WaveType waveType, Fr
     return newGrain;
 }
 
+/**
+ * Sets how createDynamicGrain makes room for a new grain when all
+ * GRAIN_POOL_SIZE grains are in use.
+ *
+ * @param policy STEAL_OLDEST, STEAL_QUIETEST or STEAL_NONE
+ */
+void VibrosonicsAPI::setGrainStealPolicy(grainStealPolicy policy)
+{
+    grainList.setStealPolicy(policy);
+}
+
 /**
  * Calls update for every grain in the grain list
- * Deletes dynamic grains as needed.
+ * Reaps finished dynamic grains as needed. The grains' waves are collected
+ * in the wave batch, so grains on the same pitch share a wave, and are
+ * submitted together with any queued waves.
  */
 void VibrosonicsAPI::updateGrains()
 {
-    grainList.updateAndReap();
+    VIBROSONICS_PROFILE_SCOPE(profiler, "updateGrains");
+#ifdef VIBROSONICS_LOW_MEMORY
+    grainList.updateAndReap(nullptr);
+#else
+    grainList.updateAndReap(&waveBatch);
+    waveBatch.submit();
+#endif
 }
 
 /**
@@ -450,8 +1198,469 @@ void VibrosonicsAPI::setGrainDurEnv(Grain* grains, int numGrains, DurEnv durEnv)
 
 /**
  * Checks if the a new audio window has been recorded by seeing if our input buffer is full.
+ *
+ * Polling also ends the timing of the previous window, and a new window
+ * starts the timing of the next, see getDeadlineMonitor, and frees the
+ * scratch spans of the previous window, see getScratchArena.
  */
 bool VibrosonicsAPI::isAudioLabReady()
 {
-  return AudioLab.ready<complex>(vData);
+  if (isPipelined()) {
+    Serial.printf("Error: the pipelined front end reads AudioLab, use acquireSpectrum instead.\n");
+    return false;
+  }
+  deadlineMonitor.windowDone();
+  bool ready = captureWindow();
+  if (ready) {
+    deadlineMonitor.windowReady();
+    scratchArena.reset();
+    if (slidingDFT && slidingDFT->getNumBins() > 0) {
+      feedSlidingDFT();
+    }
+  }
+  return ready;
+}
+
+/**
+ * Sets the sliding DFT bank to feed. The bank is owned by the sketch, and
+ * the bins added to it are updated with every sample of each window captured
+ * by isAudioLabReady, so sketches that only need a few bins can read their
+ * magnitudes without calling processAudioInput at all. Nothing is fed while
+ * no bank is set or it tracks no bins, nor in pipelined mode.
+ *
+ * @param slidingDFT The bank to feed, or nullptr to stop feeding one.
+ */
+void VibrosonicsAPI::setSlidingDFT(SlidingDFT* slidingDFT)
+{
+    this->slidingDFT = slidingDFT;
+}
+
+/**
+ * Returns the sliding DFT bank set with setSlidingDFT.
+ *
+ * @return SlidingDFT*, or nullptr if none is set.
+ */
+SlidingDFT* VibrosonicsAPI::getSlidingDFT()
+{
+    return slidingDFT;
+}
+
+/**
+ * Feeds every sample of the window just captured to the sliding DFT, oldest
+ * first.
+ */
+void VibrosonicsAPI::feedSlidingDFT()
+{
+#ifdef VIBROSONICS_FIXED_POINT
+    for (int i = 0; i < WINDOW_SIZE; i++) {
+        slidingDFT->update((float)adcSamples[i]);
+    }
+#else
+#ifdef VIBROSONICS_OVERLAP
+    if (hopSize < WINDOW_SIZE) {
+        slidingDFT->update(sampleHistory + historyEnd - WINDOW_SIZE, WINDOW_SIZE);
+        return;
+    }
+#endif
+    for (int i = 0; i < WINDOW_SIZE; i++) {
+        slidingDFT->update(vData[i].re());
+    }
+#endif
+}
+
+/**
+ * Copies the next AudioLab input window into the front end's input buffer,
+ * or into the older half of the sample history when windows overlap, and
+ * marks all of its hops as pending.
+ *
+ * @return true if a new window was captured.
+ */
+bool VibrosonicsAPI::captureWindow()
+{
+#ifdef VIBROSONICS_FIXED_POINT
+  if (!AudioLab.ready<int>(adcSamples)) {
+    return false;
+  }
+#else
+#ifdef VIBROSONICS_OVERLAP
+  if (hopSize < WINDOW_SIZE) {
+    // the history holds two windows, so a new one always fills one half
+    int end = historyEnd == WINDOW_SIZE ? 2 * WINDOW_SIZE : WINDOW_SIZE;
+    if (!AudioLab.ready<float>(sampleHistory + end - WINDOW_SIZE)) {
+      return false;
+    }
+    historyEnd = end;
+  } else
+#endif
+  if (!AudioLab.ready<complex>(vData)) {
+    return false;
+  }
+#endif
+  pendingHops = WINDOW_SIZE / hopSize;
+  return true;
+}
+
+/**
+ * Returns the monitor that times each window against the window deadline,
+ * WINDOW_SIZE / SAMPLE_RATE, for its overrun and dropped window counts, or to
+ * replace its clock.
+ *
+ * @return DeadlineMonitor*
+ */
+DeadlineMonitor* VibrosonicsAPI::getDeadlineMonitor()
+{
+    return &deadlineMonitor;
+}
+
+/**
+ * Sets the load thresholds and what the API does at each load level: cap the
+ * number of dynamic grains createDynamicGrain allows, lower the reference
+ * cells of noiseFloorCFAR, and report optional stages as skippable through
+ * shouldRunOptionalStages.
+ *
+ * @param policy The DegradationPolicy to use.
+ */
+void VibrosonicsAPI::setDegradationPolicy(DegradationPolicy policy)
+{
+    deadlineMonitor.setPolicy(policy);
+}
+
+/**
+ * Returns how close the window loop runs to the window deadline.
+ *
+ * @return loadLevel
+ */
+loadLevel VibrosonicsAPI::getLoadLevel()
+{
+    return deadlineMonitor.getLoadLevel();
+}
+
+/**
+ * Returns false if the degradation policy skips optional stages at the
+ * current load level. Sketches check this before analysis they can do
+ * without.
+ *
+ * @return bool
+ */
+bool VibrosonicsAPI::shouldRunOptionalStages()
+{
+    return deadlineMonitor.allowsOptionalStages();
+}
+
+/**
+ * Prints the count, minimum, mean, maximum and 99th percentile time of every
+ * profiled stage, and how close each comes to the window deadline. Does
+ * nothing unless the library is built with VIBROSONICS_PROFILE defined.
+ */
+void VibrosonicsAPI::printProfile()
+{
+#ifdef VIBROSONICS_PROFILE
+    profiler.report();
+#endif
+}
+
+/**
+ * Clears the timing statistics of every profiled stage, e.g. after warming
+ * up. Does nothing unless the library is built with VIBROSONICS_PROFILE
+ * defined.
+ */
+void VibrosonicsAPI::resetProfile()
+{
+#ifdef VIBROSONICS_PROFILE
+    profiler.reset();
+#endif
+}
+
+/**
+ * Returns the bytes of RAM the API holds, including the grain pool, plus the
+ * envelope curves the library shares between all instances.
+ * Buffers owned by the sketch and AudioLab's own are not included.
+ *
+ * @return size_t
+ */
+size_t VibrosonicsAPI::memoryFootprint()
+{
+    return sizeof(VibrosonicsAPI) + EnvelopeCurveCache::tableMemory();
+}
+
+//! Prints one row of printMemoryFootprint.
+static void printFootprintRow(const char* part, size_t bytes)
+{
+    Serial.printf("%-28s %8u\n", part, (unsigned)bytes);
+}
+
+/**
+ * Prints the bytes of RAM held by each part of the API, as counted by
+ * memoryFootprint, followed by the constant tables kept in flash. Useful to
+ * see what is left for larger windows or a longer SPECTRUM_HISTORY, and what
+ * building with VIBROSONICS_LOW_MEMORY saves.
+ */
+void VibrosonicsAPI::printMemoryFootprint()
+{
+    size_t parts[] = {
+        sizeof(vData),
+#ifdef VIBROSONICS_OVERLAP
+        sizeof(sampleHistory),
+#endif
+        sizeof(spectrumRing),
+#ifndef VIBROSONICS_LOW_MEMORY
+        sizeof(binRe) + sizeof(binIm),
+        sizeof(cfarScratch),
+#endif
+#ifdef VIBROSONICS_FIXED_POINT
+        sizeof(fixedPipeline) + sizeof(adcSamples) + sizeof(fixedData),
+#endif
+        sizeof(grainList),
+#ifndef VIBROSONICS_LOW_MEMORY
+        sizeof(waveBatch),
+#endif
+        sizeof(amplitudeNormalizer),
+        sizeof(deadlineMonitor),
+        sizeof(scratchArena),
+    };
+    const char* names[] = {
+        "front end buffer",
+#ifdef VIBROSONICS_OVERLAP
+        "sample history",
+#endif
+        "spectrum ring",
+#ifndef VIBROSONICS_LOW_MEMORY
+        "phase vocoder bins",
+        "CFAR scratch",
+#endif
+#ifdef VIBROSONICS_FIXED_POINT
+        "fixed-point front end",
+#endif
+        "grain pool",
+#ifndef VIBROSONICS_LOW_MEMORY
+        "wave batch",
+#endif
+        "amplitude normalizer",
+        "deadline monitor",
+        "scratch arena",
+    };
+
+    Serial.printf("%-28s %8s\n", "RAM", "bytes");
+    size_t listed = 0;
+    for (size_t i = 0; i < sizeof(parts) / sizeof(parts[0]); i++) {
+        printFootprintRow(names[i], parts[i]);
+        listed += parts[i];
+    }
+    printFootprintRow("other state", sizeof(VibrosonicsAPI) - listed);
+    printFootprintRow("envelope curves", EnvelopeCurveCache::tableMemory());
+    printFootprintRow("total", memoryFootprint());
+    Serial.printf("scratch arena high-water mark: %u of %u bytes\n",
+        (unsigned)scratchArena.getHighWaterMark(), (unsigned)scratchArena.getCapacity());
+
+    Serial.printf("%-28s %8s\n", "flash", "bytes");
+    printFootprintRow("window and FFT tables", sizeof(Tables::Hamming::values) + sizeof(Tables::TwiddleCos::values)
+        + sizeof(Tables::TwiddleSin::values) + sizeof(Tables::BitReverse::values));
+    printFootprintRow("oscillator wavetables", OscillatorBank::tableMemory());
+}
+
+/**
+ * Returns the arena sketches take the temporary buffers of a window from,
+ * e.g. the output of noiseFloorCFAR, instead of keeping a global array for
+ * each. It is reset whenever isAudioLabReady or acquireSpectrum starts a new
+ * window, so spans must be taken after that and are only valid until the
+ * next window. Its high-water mark tells how large SCRATCH_ARENA_SIZE needs
+ * to be for the program.
+ *
+ * @return ScratchArena*
+ */
+ScratchArena* VibrosonicsAPI::getScratchArena()
+{
+    return &scratchArena;
+}
+
+/**
+ * Starts running the front end on another core, so that the next window is
+ * captured and transformed while the sketch analyzes and synthesizes the
+ * current one. Spectra are handed over through a ring of PIPELINE_DEPTH
+ * frames; the sketch takes them with acquireSpectrum instead of calling
+ * isAudioLabReady and processAudioInput, which belong to the front end while
+ * the pipeline runs.
+ *
+ * On the ESP32 the front end is a FreeRTOS task pinned to PIPELINE_CORE. On
+ * the host it is a std::thread. With VIBROSONICS_LOW_MEMORY there is no
+ * pipelined mode, since the front end's buffer doubles as CFAR scratch.
+ *
+ * @return true if the pipeline was started or was already running.
+ */
+bool VibrosonicsAPI::startPipeline()
+{
+#ifdef VIBROSONICS_LOW_MEMORY
+    Serial.printf("Error: pipelined mode is not available with VIBROSONICS_LOW_MEMORY.\n");
+    return false;
+#endif
+    if (isPipelined()) {
+        return true;
+    }
+    spectrumRing.clear();
+
+    // the phase vocoder bins stay with the analysis core, the front end
+    // keeps none while pipelined
+    keepBins     = false;
+    numBinFrames = 0;
+
+    pipeline.drops   = 0;
+    pipeline.stopped = false;
+    pipeline.running = true;
+
+#if defined(ARDUINO_ARCH_ESP32)
+    if (xTaskCreatePinnedToCore(pipelineTask, "vibrosonics_fe", PIPELINE_STACK_SIZE, this, 1,
+            &pipeline.task, PIPELINE_CORE) != pdPASS) {
+        Serial.printf("Error: could not create the pipelined front end task.\n");
+        pipeline.running = false;
+        pipeline.stopped = true;
+        return false;
+    }
+#elif !defined(ARDUINO)
+    pipeline.thread = std::thread(pipelineTask, this);
+#else
+    Serial.printf("Error: pipelined mode is not supported on this board.\n");
+    pipeline.running = false;
+    pipeline.stopped = true;
+    return false;
+#endif
+    return true;
+}
+
+/**
+ * Stops the pipelined front end and waits for it to finish its current
+ * window. Spectra still in the ring are discarded.
+ */
+void VibrosonicsAPI::stopPipeline()
+{
+    if (!isPipelined()) {
+        return;
+    }
+    pipeline.running = false;
+#if defined(ARDUINO_ARCH_ESP32)
+    while (!pipeline.stopped) {
+        vTaskDelay(1);
+    }
+    pipeline.task = nullptr;
+#elif !defined(ARDUINO)
+    pipeline.thread.join();
+#endif
+    spectrumRing.clear();
+}
+
+/**
+ * Returns true while the front end runs on another core.
+ *
+ * @return bool
+ */
+bool VibrosonicsAPI::isPipelined()
+{
+    return pipeline.running;
+}
+
+/**
+ * Returns the oldest spectrum the pipelined front end has finished. The
+ * spectrum belongs to the caller, who may change it in place, until it is
+ * handed back with releaseSpectrum.
+ *
+ * Like isAudioLabReady, this times each window against the deadline, from
+ * the call that returns it to the next call, and a new spectrum frees the
+ * scratch spans of the previous window.
+ *
+ * @return WINDOW_SIZE_BY_2 magnitudes, or nullptr if no new window is ready.
+ */
+float* VibrosonicsAPI::acquireSpectrum()
+{
+    deadlineMonitor.windowDone();
+    float* spectrum = spectrumRing.beginRead();
+    if (spectrum) {
+        deadlineMonitor.windowReady();
+        scratchArena.reset();
+    }
+    return spectrum;
+}
+
+/**
+ * Hands the spectrum returned by acquireSpectrum back to the front end. It
+ * becomes the newest spectrum of the history, see getSpectrum, and is reused
+ * once SPECTRUM_HISTORY newer spectra have been released.
+ */
+void VibrosonicsAPI::releaseSpectrum()
+{
+    spectrumRing.endRead();
+}
+
+/**
+ * Returns the number of spectra (one per window, or per hop when windows
+ * overlap) the pipelined front end dropped because every frame of the ring
+ * was still waiting to be analyzed.
+ *
+ * @return uint32_t
+ */
+uint32_t VibrosonicsAPI::getPipelineDrops()
+{
+    return pipeline.drops;
+}
+
+/**
+ * Captures each new window and transforms each of its hops straight into a
+ * free frame of the spectrum ring, until stopPipeline is called. If analysis
+ * has fallen so far behind that no frame is free, the hop is dropped.
+ */
+void VibrosonicsAPI::pipelineLoop()
+{
+    while (pipeline.running) {
+        if (!captureWindow()) {
+#if defined(ARDUINO_ARCH_ESP32)
+            vTaskDelay(1);
+#elif !defined(ARDUINO)
+            std::this_thread::yield();
+#endif
+            continue;
+        }
+
+        while (pendingHops > 0) {
+            float* frame = spectrumRing.beginWrite();
+            if (!frame) {
+                pipeline.drops++;
+                pendingHops--;
+                continue;
+            }
+            runFrontEnd(frame);
+            spectrumRing.commitWrite();
+        }
+    }
+}
+
+/**
+ * Entry point of the pipelined front end.
+ *
+ * @param api The VibrosonicsAPI that started the pipeline.
+ */
+void VibrosonicsAPI::pipelineTask(void* api)
+{
+    VibrosonicsAPI* self = (VibrosonicsAPI*)api;
+    self->pipelineLoop();
+    self->pipeline.stopped = true;
+#if defined(ARDUINO_ARCH_ESP32)
+    vTaskDelete(nullptr);
+#endif
+}
+
+/**
+ * Stops a pipelined front end that is still running when the API is
+ * destroyed and waits for it to finish, like stopPipeline, so it never
+ * writes into a destroyed API.
+ */
+VibrosonicsAPI::PipelineState::~PipelineState()
+{
+    running = false;
+#if defined(ARDUINO_ARCH_ESP32)
+    while (!stopped) {
+        vTaskDelay(1);
+    }
+#elif !defined(ARDUINO)
+    if (thread.joinable()) {
+        thread.join();
+    }
+#endif
 }
@@ -11,14 +11,32 @@
 #include <Fast4ier.h>
 
 // standard libraries
+#include <atomic>
 #include <complex>
 #include <cstdint>
+#if !defined(ARDUINO)
+#include <thread>
+#endif
 
 // internal
+#include "AmplitudeNormalizer.h"
+#include "DeadlineMonitor.h"
+#include "FixedPoint.h"
 #include "Grain.h"
+#include "GrainBank.h"
+#include "Kernels.h"
+#include "OscillatorBank.h"
+#include "PercussiveMelodicSplit.h"
+#include "Profiler.h"
+#include "ScratchArena.h"
+#include "SlidingDFT.h"
+#include "SpectrumRing.h"
 #include "Wave.h"
+#include "WaveBatch.h"
+#include "WindowTables.h"
 
 constexpr int WINDOW_SIZE_BY_2 = WINDOW_SIZE >> 1;
+constexpr int WINDOW_SIZE_BY_4 = WINDOW_SIZE >> 2;
 
 //! Frequency range of an FFT bin in Hz.
 //!
@@ -35,6 +53,78 @@ constexpr float FREQ_RES = (float)SAMPLE_RATE / (float)WINDOW_SIZE;
 //! Ex: 256 Samples/Window / 8192 Samples/Second = 0.03125 Seconds/Window.
 constexpr float FREQ_WIDTH = 1.0 / FREQ_RES;
 
+#ifdef VIBROSONICS_FIXED_POINT
+//! Sample type of the fixed-point analysis chain, selected by building with
+//! VIBROSONICS_FIXED_POINT defined as q15_t or q31_t.
+typedef VIBROSONICS_FIXED_POINT fixed_t;
+#endif
+
+#if !defined(VIBROSONICS_FIXED_POINT) && !defined(VIBROSONICS_LOW_MEMORY)
+//! Defined when windows can overlap, which needs the float front end and the
+//! RAM of a sample history, so neither fixed-point nor low memory builds can.
+#define VIBROSONICS_OVERLAP
+#endif
+
+#ifndef PIPELINE_DEPTH
+//! Number of spectrum frames that can wait between the front end and the
+//! analysis in pipelined mode. VIBROSONICS_LOW_MEMORY has no pipelined mode
+//! and only keeps the frame processAudioInput writes.
+#ifdef VIBROSONICS_LOW_MEMORY
+#define PIPELINE_DEPTH 1
+#else
+#define PIPELINE_DEPTH 4
+#endif
+#endif
+
+#ifndef SPECTRUM_HISTORY
+//! Number of past spectra kept for getSpectrum. VIBROSONICS_LOW_MEMORY keeps
+//! only the newest.
+#ifdef VIBROSONICS_LOW_MEMORY
+#define SPECTRUM_HISTORY 1
+#else
+#define SPECTRUM_HISTORY 2
+#endif
+#endif
+
+#ifndef PIPELINE_CORE
+//! ESP32 core the pipelined front end runs on; Arduino's loop runs on core 1.
+#define PIPELINE_CORE 0
+#endif
+
+#ifndef PIPELINE_STACK_SIZE
+//! Stack size in bytes of the pipelined front end task on the ESP32.
+#define PIPELINE_STACK_SIZE 4096
+#endif
+
+//! Rank of the reference cell used as the noise level by OS-CFAR, as a
+//! fraction of the number of reference cells.
+constexpr float OS_CFAR_RANK = 0.75f;
+
+/**
+ * @type CFARType
+ *
+ * Enum for selecting how CFAR estimates the noise level around a cell from
+ * its leading and lagging reference cells.
+ */
+enum CFARType {
+    CA_CFAR, //!< Cell averaging: mean of all reference cells
+    GO_CFAR, //!< Greatest of: larger of the leading and lagging means
+    SO_CFAR, //!< Smallest of: smaller of the leading and lagging means
+    OS_CFAR  //!< Order statistic: reference cell at OS_CFAR_RANK when sorted
+};
+
+/**
+ * @type peakEstimator
+ *
+ * Enum for selecting how refinePeaks estimates where a peak lies between
+ * bins.
+ */
+enum peakEstimator {
+    PEAK_PARABOLIC,    //!< Parabola through the peak bin's and its neighbours' magnitudes
+    PEAK_GAUSSIAN,     //!< Parabola through their logarithms (log-parabolic)
+    PEAK_PHASE_VOCODER //!< Phase advance of the peak bin since the previous spectrum
+};
+
 class VibrosonicsAPI {
 public:
     // ---- Setup ------------------------------------------------------------------
@@ -48,16 +138,38 @@ public:
     //! Perform fast fourier transform on the AudioLab input buffer.
     void processAudioInput(float* output);
 
-    //! Pre compute hamming windows for FFT operations
+    //! Perform fast fourier transform on the AudioLab input buffer, into the
+    //! next frame of the spectrum history.
+    float* processAudioInput();
+
+    //! Returns a spectrum from the history, 0 being the newest.
+    const float* getSpectrum(int age);
+
+    //! Sets the number of samples between consecutive spectra.
+    bool setHopSize(int hopSize);
+
+    //! Returns the number of samples between consecutive spectra.
+    int getHopSize();
+
+    //! Returns the number of hops of the captured window not yet transformed.
+    int getPendingHops();
+
+    //! Does nothing, the hamming window is generated at compile time.
     void computeHammingWindow();
 
-    //! Perform DC Removal to reduce noise in vReal.
+    //! Does nothing, the twiddle factors are generated at compile time.
+    void computeTwiddleFactors();
+
+    //! Perform DC Removal to reduce noise in vData.
     void dcRemoval();
 
-    //! Applies windowing function to vReal data.
+    //! Applies windowing function to vData.
     void fftWindowing();
 
-    //! Computes frequency magnitudes in vReal data.
+    //! Performs a real-input FFT on the samples in vData.
+    void realFFT();
+
+    //! Computes frequency magnitudes in vData.
     void complexToMagnitude();
 
     //! Returns the mean of some float data.
@@ -72,6 +184,34 @@ public:
     //! Floors data using the CFAR algorithm.
     void noiseFloorCFAR(float* data, int numRefs, int numGuards, float bias);
 
+    //! Floors input data into output using the selected CFAR algorithm.
+    void noiseFloorCFAR(const float* input, float* output, int numRefs,
+        int numGuards, float bias, CFARType type = CA_CFAR);
+
+    //! Refines the frequencies and amplitudes of peaks to between bins.
+    void refinePeaks(const float* data, const float* peakFreqs, float* freqs,
+        float* amps, int numPeaks, peakEstimator estimator = PEAK_PARABOLIC);
+
+#ifdef VIBROSONICS_FIXED_POINT
+    // --- Fixed-Point Analysis ----------------------------------------------------
+
+    //! Perform fixed-point FFT on the AudioLab input samples.
+    void processAudioInput(fixed_t* output);
+
+    //! Floors fixed-point data that is below a certain threshold.
+    void noiseFloor(fixed_t* data, fixed_t threshold);
+
+    //! Floors fixed-point data using cell averaging CFAR.
+    void noiseFloorCFAR(const fixed_t* input, fixed_t* output, int numRefs,
+        int numGuards, float bias);
+
+    //! Converts fixed-point magnitudes to the float path's units.
+    void fixedToFloat(const fixed_t* input, float* output, int dataLength);
+
+    //! Converts a float path magnitude or threshold to fixed-point.
+    fixed_t floatToFixed(float magnitude);
+#endif
+
     // --- AudioLab Interactions ---------------------------------------------------
 
     //! Add a wave to a channel with specified frequency and amplitude.
@@ -81,14 +221,51 @@ public:
     //! arrays.
     void assignWaves(float* freqs, float* amps, int dataLength, int channel);
 
+    //! Queue a wave for the next submitWaves, merged with equal queued waves.
+    void queueWave(float freq, float amp, int channel, WaveType type = SINE);
+
+    //! Queue waves from the values in the frequency and amplitude arrays.
+    void queueWaves(float* freqs, float* amps, int dataLength, int channel);
+
+    //! Create every queued wave in one pass.
+    int submitWaves();
+
+    //! Returns the batch that queued waves and grain waves are collected in.
+    WaveBatch* getWaveBatch();
+
     //! Check if a new audio window has been recorded
     bool isAudioLabReady();
 
+    // --- Tracked Bins ------------------------------------------------------------
+
+    //! Sets a sliding DFT for isAudioLabReady to feed every captured sample.
+    void setSlidingDFT(SlidingDFT* slidingDFT);
+
+    //! Returns the sliding DFT set with setSlidingDFT, or nullptr.
+    SlidingDFT* getSlidingDFT();
+
+    // --- Deadline ----------------------------------------------------------------
+
+    //! Returns the monitor timing each window against the window deadline.
+    DeadlineMonitor* getDeadlineMonitor();
+
+    //! Sets when the load level changes and how the API degrades at each level.
+    void setDegradationPolicy(DegradationPolicy policy);
+
+    //! Returns how close the window loop runs to the window deadline.
+    loadLevel getLoadLevel();
+
+    //! Returns false if optional stages should be skipped at the current load.
+    bool shouldRunOptionalStages();
+
     // --- Wave Manipulation -------------------------------------------------------
 
     //! Maps amplitudes in some data to between 0.0-1.0 range.
     void mapAmplitudes(float* ampData, int dataLength, float minAmpSum = 10000,
-        float smoothFactor = 0.05);
+        float smoothFactor = 0.05, int stream = 0);
+
+    //! Returns the normalizer holding the state of each mapAmplitudes stream.
+    AmplitudeNormalizer* getAmplitudeNormalizer();
 
     //! Maps a frequency to the haptic range (0-230Hz) by transposing it down
     //! by octaves.
@@ -111,6 +288,9 @@ public:
     //! Also takes frequency and amplitude envelopes for immediate triggering.
     Grain* createDynamicGrain(uint8_t channel, WaveType waveType, FreqEnv freqEnv, AmpEnv ampEnv, DurEnv durEnv);
 
+    //! Sets how dynamic grains are stolen when the grain pool is full.
+    void setGrainStealPolicy(grainStealPolicy policy);
+
     //! Updates an array of numPeaks grains sustain and release windows.
     void triggerGrains(Grain* grains, int numGrains, FreqEnv freqEnv, AmpEnv ampEnv, DurEnv durEnv);
 
@@ -132,15 +312,166 @@ public:
     //! Sets the duration envelope paramaters for an array of grains.
     void setGrainDurEnv(Grain* grains, int numGrains, DurEnv durEnv);
 
+    // --- Pipelining --------------------------------------------------------------
+
+    //! Starts running the front end for upcoming windows on another core.
+    bool startPipeline();
+
+    //! Stops the pipelined front end.
+    void stopPipeline();
+
+    //! Returns true while the front end runs on another core.
+    bool isPipelined();
+
+    //! Returns the next spectrum from the pipelined front end, or nullptr.
+    float* acquireSpectrum();
+
+    //! Hands the spectrum from acquireSpectrum back to the front end.
+    void releaseSpectrum();
+
+    //! Returns the number of spectra the pipelined front end had to drop.
+    uint32_t getPipelineDrops();
+
+    // --- Profiling ---------------------------------------------------------------
+
+#ifdef VIBROSONICS_PROFILE
+    //! Per stage timing statistics, filled by VIBROSONICS_PROFILE_SCOPE. The
+    //! API times its own stages; sketches can add theirs with
+    //! VIBROSONICS_PROFILE_SCOPE(vapi.profiler, "name").
+    StageProfiler profiler;
+#endif
+
+    //! Prints the timing statistics of every profiled stage.
+    void printProfile();
+
+    //! Clears the timing statistics of every profiled stage.
+    void resetProfile();
+
+    // --- Memory ------------------------------------------------------------------
+
+    //! Returns the bytes of RAM held by the API and the library's shared tables.
+    size_t memoryFootprint();
+
+    //! Prints the RAM held by each part of the API, and the tables in flash.
+    void printMemoryFootprint();
+
+    //! Returns the arena of per-window scratch buffers, reset every window.
+    ScratchArena* getScratchArena();
+
 private:
+    // Hamming window and twiddle factors, generated at compile time into flash
+    typedef WindowTables<WINDOW_SIZE> Tables;
+
     // Fast Fourier Transform uses complex numbers
-    float   vReal[WINDOW_SIZE];   //!< Real component of cosine amplitude of each frequency.
-    float   hamming[WINDOW_SIZE]; //!< Pre computed hamming window data
     complex vData[WINDOW_SIZE];
 
+#ifdef VIBROSONICS_OVERLAP
+    // Overlapping windows are read from the last two captured windows, which
+    // are only written while hopSize is below WINDOW_SIZE
+    float sampleHistory[2 * WINDOW_SIZE]; //!< Circular history of input samples
+    int   historyEnd = 0;                 //!< Index just past the newest sample in sampleHistory
+#endif
+    int hopSize     = WINDOW_SIZE; //!< Samples between spectra, WINDOW_SIZE without overlap
+    int pendingHops = 0;           //!< Hops of the captured window not yet transformed
+
+#ifndef VIBROSONICS_LOW_MEMORY
+    // Complex bins of the last two spectra, kept once PEAK_PHASE_VOCODER is used
+    float binRe[2][WINDOW_SIZE_BY_2];
+    float binIm[2][WINDOW_SIZE_BY_2];
+#endif
+    bool  keepBins     = false; //!< Whether runFrontEnd fills binRe and binIm
+    int   binFrame     = 0;     //!< Index of the newest spectrum in binRe and binIm
+    int   numBinFrames = 0;     //!< Spectra kept so far, up to 2
+
+#ifdef VIBROSONICS_FIXED_POINT
+    FixedPointPipeline<fixed_t> fixedPipeline;
+    int                         adcSamples[WINDOW_SIZE]; //!< Raw ADC samples of the window
+    fixed_t                     fixedData[WINDOW_SIZE_BY_2];
+#endif
+
+#ifndef VIBROSONICS_LOW_MEMORY
+    //! Shared CFAR scratch: prefix sums, or the sorted reference cells for OS-CFAR
+    float cfarScratch[WINDOW_SIZE_BY_2 + 1];
+#endif
+
+    //! Returns the WINDOW_SIZE_BY_2 + 1 floats of CFAR scratch.
+    float* getCFARScratch();
+
+    //! Floors one edge cell of a cell averaging CFAR.
+    void noiseFloorCFARCell(const float* input, float* output, int i, int numRefs,
+        int numGuards, float bias, CFARType type);
+
+    //! Floors input data into output using order statistic CFAR.
+    void noiseFloorOSCFAR(const float* input, float* output, int numRefs,
+        int numGuards, float bias);
+
+    //! Returns the offset in bins of a peak from its phase advance.
+    float phaseVocoderOffset(int bin);
+
+    //! Splits bin k of the packed half-size transform in vData.
+    void splitBins(int k, float& evenRe, float& evenIm, float& rotRe, float& rotIm);
+
+    //! Copies the next AudioLab window into the front end's input buffer.
+    bool captureWindow();
+
+#ifdef VIBROSONICS_OVERLAP
+    //! Removes DC, windows and packs the oldest pending hop into vData.
+    void packHop();
+#endif
+
+    //! Feeds the samples of the captured window to the sliding DFT.
+    void feedSlidingDFT();
+
+    //! Computes the magnitudes of the captured window into output.
+    void runFrontEnd(float* output);
+
+    // --- Pipelining --------------------------------------------------------------
+
+    //! Frames handed from the front end to the analysis, the last
+    //! SPECTRUM_HISTORY of which are kept as history
+    SpectrumRing<WINDOW_SIZE_BY_2, PIPELINE_DEPTH + SPECTRUM_HISTORY, SPECTRUM_HISTORY> spectrumRing;
+
+    //! Shared state of the pipelined front end. A copy starts stopped.
+    struct PipelineState {
+        std::atomic<bool>     running { false };
+        std::atomic<bool>     stopped { true };
+        std::atomic<uint32_t> drops { 0 };
+#if defined(ARDUINO_ARCH_ESP32)
+        TaskHandle_t task = nullptr;
+#elif !defined(ARDUINO)
+        std::thread thread;
+#endif
+        PipelineState() { }
+        PipelineState(const PipelineState&) { }
+        ~PipelineState();
+    } pipeline;
+
+    //! Captures and transforms windows into the spectrum ring until stopped.
+    void pipelineLoop();
+
+    //! Entry point of the pipelined front end task or thread.
+    static void pipelineTask(void* api);
+
     // --- AudioLab Library --------------------------------------------------------
 
     GrainList grainList;
+
+#ifndef VIBROSONICS_LOW_MEMORY
+    //! Waves queued for the next submitWaves
+    WaveBatch waveBatch;
+#endif
+
+    //! Smoothed sums of the mapAmplitudes streams
+    AmplitudeNormalizer amplitudeNormalizer;
+
+    //! Bins tracked sample by sample, owned by the sketch
+    SlidingDFT* slidingDFT = nullptr;
+
+    //! Times each window from isAudioLabReady to the next poll
+    DeadlineMonitor deadlineMonitor;
+
+    //! Scratch buffers of the current window
+    ScratchArena scratchArena;
 };
 
 #endif // VIBROSONICS_API_H
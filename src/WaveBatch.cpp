@@ -0,0 +1,161 @@
+/**
+ * @file WaveBatch.cpp
+ *
+ * This file is part of the WaveBatch class.
+ */
+
+#include "WaveBatch.h"
+
+/**
+ * Creates a batch with empty lists.
+ */
+WaveBatch::WaveBatch()
+{
+    clear();
+}
+
+/**
+ * Adds a wave to a channel's list. If the list already holds a wave with the
+ * same frequency, phase and type, the amplitude is added to that wave
+ * instead, so every frequency is created once per channel.
+ *
+ * @param channel The output channel of the wave.
+ * @param freq Frequency of the wave.
+ * @param amp Amplitude of the wave.
+ * @param phase Phase of the wave.
+ * @param type Shape of the wave.
+ * @return false if the channel is out of range, or its list already holds
+ * WAVE_BATCH_SIZE waves none of which the wave merges with.
+ */
+bool WaveBatch::add(int channel, float freq, float amp, float phase, WaveType type)
+{
+    if (channel < 0 || channel >= AUD_OUT_CH) {
+        return false;
+    }
+
+    float*   freqs = frequency[channel];
+    int      count = numWaves[channel];
+    for (int i = 0; i < count; i++) {
+        if (freqs[i] == freq && this->phase[channel][i] == phase && this->type[channel][i] == type) {
+            amplitude[channel][i] += amp;
+            numAdded++;
+            return true;
+        }
+    }
+
+    if (count >= WAVE_BATCH_SIZE) {
+        return false;
+    }
+    freqs[count]                = freq;
+    amplitude[channel][count]   = amp;
+    this->phase[channel][count] = phase;
+    this->type[channel][count]  = type;
+    numWaves[channel]           = count + 1;
+    numAdded++;
+    return true;
+}
+
+/**
+ * Creates every listed wave with AudioLab.dynamicWave, channel by channel
+ * straight from the arrays, and clears the lists for the next window.
+ *
+ * @return The number of waves created.
+ */
+int WaveBatch::submit()
+{
+    int created = 0;
+    for (int ch = 0; ch < AUD_OUT_CH; ch++) {
+        const float*   freqs  = frequency[ch];
+        const float*   amps   = amplitude[ch];
+        const float*   phases = phase[ch];
+        const uint8_t* types  = type[ch];
+        for (int i = 0; i < numWaves[ch]; i++) {
+            AudioLab.dynamicWave(ch, freqs[i], amps[i], phases[i], (WaveType)types[i]);
+        }
+        created += numWaves[ch];
+    }
+    clear();
+    return created;
+}
+
+/**
+ * Empties every channel's list without creating its waves.
+ */
+void WaveBatch::clear()
+{
+    for (int ch = 0; ch < AUD_OUT_CH; ch++) {
+        numWaves[ch] = 0;
+    }
+    numAdded = 0;
+}
+
+/**
+ * Returns the number of distinct waves listed for a channel, which is the
+ * number submit will create for it.
+ *
+ * @param channel The output channel.
+ * @return int
+ */
+int WaveBatch::getNumWaves(int channel)
+{
+    if (channel < 0 || channel >= AUD_OUT_CH) {
+        return 0;
+    }
+    return numWaves[channel];
+}
+
+/**
+ * Returns the number of waves added since the last submit or clear, counting
+ * every wave that was merged into another.
+ *
+ * @return int
+ */
+int WaveBatch::getNumAdded()
+{
+    return numAdded;
+}
+
+/**
+ * Returns the frequencies listed for a channel, getNumWaves(channel) of them.
+ *
+ * @param channel The output channel, in range.
+ * @return const float*
+ */
+const float* WaveBatch::getFrequencies(int channel)
+{
+    return frequency[channel];
+}
+
+/**
+ * Returns the amplitudes listed for a channel, getNumWaves(channel) of them.
+ *
+ * @param channel The output channel, in range.
+ * @return const float*
+ */
+const float* WaveBatch::getAmplitudes(int channel)
+{
+    return amplitude[channel];
+}
+
+/**
+ * Returns the phases listed for a channel, getNumWaves(channel) of them.
+ *
+ * @param channel The output channel, in range.
+ * @return const float*
+ */
+const float* WaveBatch::getPhases(int channel)
+{
+    return phase[channel];
+}
+
+/**
+ * Returns the wave types listed for a channel, getNumWaves(channel) of them,
+ * as WaveType values.
+ *
+ * @param channel The output channel, in range.
+ * @return const uint8_t*
+ */
+const uint8_t* WaveBatch::getTypes(int channel)
+{
+    return type[channel];
+}
@@ -0,0 +1,68 @@
+/**
+ * @file
+ * Contains the declaration of the WaveBatch class.
+*/
+
+#ifndef WaveBatch_h
+#define WaveBatch_h
+
+#include <AudioLab.h>
+
+#ifndef WAVE_BATCH_SIZE
+//! Maximum number of distinct waves a WaveBatch holds per output channel.
+#define WAVE_BATCH_SIZE MAX_NUM_WAVES
+#endif
+
+/**
+ * Collects the waves of a window into compact per-channel lists before they
+ * are handed to AudioLab, instead of creating each wave where it is computed.
+ *
+ * Each channel's list is kept as parallel frequency, amplitude, phase and
+ * type arrays. A wave with the same frequency, phase and type as one already
+ * in its channel's list is merged into it by adding its amplitude, which
+ * synthesizes the same signal as the two waves did, so peaks that map to the
+ * same haptic frequency, or grains that land on the same pitch, cost a
+ * single wave. submit then creates every listed wave in one pass and clears
+ * the lists for the next window.
+ */
+class WaveBatch {
+private:
+  float   frequency[AUD_OUT_CH][WAVE_BATCH_SIZE];
+  float   amplitude[AUD_OUT_CH][WAVE_BATCH_SIZE];
+  float   phase[AUD_OUT_CH][WAVE_BATCH_SIZE];
+  uint8_t type[AUD_OUT_CH][WAVE_BATCH_SIZE];
+  int     numWaves[AUD_OUT_CH];
+  //! Number of waves added since the last submit, merged or not
+  int     numAdded;
+public:
+  //! Default constructor.
+  WaveBatch();
+
+  //! Adds a wave to a channel's list, merging it with an equal wave.
+  bool add(int channel, float freq, float amp, float phase = 0.0, WaveType type = SINE);
+
+  //! Creates every listed wave with AudioLab and clears the lists.
+  int submit();
+
+  //! Clears the lists without creating their waves.
+  void clear();
+
+  //! Returns the number of distinct waves listed for a channel.
+  int getNumWaves(int channel);
+
+  //! Returns the number of waves added since the last submit or clear.
+  int getNumAdded();
+
+  //! Returns the frequencies listed for a channel.
+  const float* getFrequencies(int channel);
+
+  //! Returns the amplitudes listed for a channel.
+  const float* getAmplitudes(int channel);
+
+  //! Returns the phases listed for a channel.
+  const float* getPhases(int channel);
+
+  //! Returns the wave types listed for a channel.
+  const uint8_t* getTypes(int channel);
+};
+#endif
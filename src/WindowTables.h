@@ -0,0 +1,159 @@
+/**
+ * @file
+ * Contains the window and FFT tables generated at compile time.
+*/
+
+#ifndef WindowTables_h
+#define WindowTables_h
+
+#include <stdint.h>
+
+/**
+ * Compile-time math for the tables. Only what C++11 allows in a constexpr
+ * function: a single return statement, recursion instead of loops.
+ */
+struct TableMath {
+  //! Pi, as a double.
+  static constexpr double pi() { return 3.14159265358979323846; }
+
+  //! Sum of the Taylor series of cos from term n on, for |x| <= pi.
+  static constexpr double cosSeries(double x2, double term, int n)
+  {
+      return n == 24 ? 0.0 : term + cosSeries(x2, -term * x2 / ((2.0 * n + 1) * (2.0 * n + 2)), n + 1);
+  }
+
+  //! cos(2 * pi * k / n), with the angle first brought into [-pi, pi].
+  static constexpr double turnCos(int k, int n)
+  {
+      return cosSeries((2.0 * k > n ? 2 * pi() * (k - n) / n : 2 * pi() * k / n)
+              * (2.0 * k > n ? 2 * pi() * (k - n) / n : 2 * pi() * k / n), 1.0, 0);
+  }
+
+  //! sin(2 * pi * k / n) for 0 <= k <= n / 2, as cos(pi / 2 - 2 * pi * k / n).
+  static constexpr double turnSin(int k, int n)
+  {
+      return cosSeries((pi() / 2 - 2 * pi() * k / n) * (pi() / 2 - 2 * pi() * k / n), 1.0, 0);
+  }
+
+  //! log2 of a power of two.
+  static constexpr int log2(int size) { return size > 1 ? 1 + log2(size / 2) : 0; }
+
+  //! The low bits of i in reverse order.
+  static constexpr int reverseBits(int i, int bits)
+  {
+      return bits == 0 ? 0 : ((i & 1) << (bits - 1)) | reverseBits(i >> 1, bits - 1);
+  }
+};
+
+//! A list of table indices, for expanding a generator over all of them.
+template <int... I>
+struct IndexList { };
+
+//! Joins two index lists, offsetting the second by the size of the first.
+template <typename A, typename B>
+struct JoinIndices;
+
+template <int... A, int... B>
+struct JoinIndices<IndexList<A...>, IndexList<B...>> {
+  typedef IndexList<A..., (int)sizeof...(A) + B...> type;
+};
+
+//! The indices 0 to N - 1, built by halving so the template depth is log2(N).
+template <int N>
+struct MakeIndices {
+  typedef typename JoinIndices<typename MakeIndices<N / 2>::type,
+      typename MakeIndices<N - N / 2>::type>::type type;
+};
+
+template <>
+struct MakeIndices<0> {
+  typedef IndexList<> type;
+};
+
+template <>
+struct MakeIndices<1> {
+  typedef IndexList<0> type;
+};
+
+/**
+ * A constexpr array of type T holding Generator::value(i) for every index of
+ * Indices. Being constant data, it is placed in flash on the ESP32.
+ */
+template <typename T, typename Generator, typename Indices>
+struct ConstTable;
+
+template <typename T, typename Generator, int... I>
+struct ConstTable<T, Generator, IndexList<I...>> {
+  static constexpr T values[sizeof...(I)] = { Generator::value(I)... };
+};
+
+template <typename T, typename Generator, int... I>
+constexpr T ConstTable<T, Generator, IndexList<I...>>::values[sizeof...(I)];
+
+//! Hamming window over Size samples, as 0.54 - 0.46 * cos(2 * pi * i / (Size - 1)).
+template <int Size>
+struct HammingGenerator {
+  static constexpr double value(int i) { return 0.54 - 0.46 * TableMath::turnCos(i, Size - 1); }
+};
+
+//! cos(2 * pi * k / Size)
+template <int Size>
+struct CosGenerator {
+  static constexpr double value(int k) { return TableMath::turnCos(k, Size); }
+};
+
+//! sin(2 * pi * k / Size), for k <= Size / 2
+template <int Size>
+struct SinGenerator {
+  static constexpr double value(int k) { return TableMath::turnSin(k, Size); }
+};
+
+//! sin(2 * pi * i / Size) for 0 <= i <= Size, a whole period and its first
+//! value again.
+template <int Size>
+struct SineGenerator {
+  static constexpr double value(int i) { return TableMath::turnCos((i + 3 * Size / 4) % Size, Size); }
+};
+
+//! Bit reversal permutation of Size indices.
+template <int Size>
+struct BitReverseGenerator {
+  static constexpr uint16_t value(int i) { return TableMath::reverseBits(i, TableMath::log2(Size)); }
+};
+
+/**
+ * The window and FFT tables for a window of WindowSize samples, generated at
+ * compile time instead of computed at startup, and kept in flash instead of
+ * RAM:
+ *
+ * - hamming: the Hamming window applied before the FFT.
+ * - twiddleCos, twiddleSin: the twiddle factors of the first quarter of the
+ *   circle, which the real-input FFT split needs.
+ * - bitReverse: the bit reversal permutation of the half-size FFT.
+ *
+ * The tables are computed in double precision with a Taylor series over
+ * angles reduced to [-pi, pi], which is exact to float precision.
+ */
+template <int WindowSize>
+struct WindowTables {
+  static_assert(WindowSize >= 4 && (WindowSize & (WindowSize - 1)) == 0, "WindowSize must be a power of two");
+
+  typedef ConstTable<float, HammingGenerator<WindowSize>, typename MakeIndices<WindowSize>::type> Hamming;
+  typedef ConstTable<float, CosGenerator<WindowSize>, typename MakeIndices<WindowSize / 4 + 1>::type> TwiddleCos;
+  typedef ConstTable<float, SinGenerator<WindowSize>, typename MakeIndices<WindowSize / 4 + 1>::type> TwiddleSin;
+  typedef ConstTable<uint16_t, BitReverseGenerator<WindowSize / 2>, typename MakeIndices<WindowSize / 2>::type> BitReverse;
+
+  //! WindowSize Hamming window coefficients.
+  static constexpr const float* hamming() { return Hamming::values; }
+
+  //! WindowSize / 4 + 1 values of cos(2 * pi * k / WindowSize).
+  static constexpr const float* twiddleCos() { return TwiddleCos::values; }
+
+  //! WindowSize / 4 + 1 values of sin(2 * pi * k / WindowSize).
+  static constexpr const float* twiddleSin() { return TwiddleSin::values; }
+
+  //! WindowSize / 2 bit reversed indices of the half-size FFT.
+  static constexpr const uint16_t* bitReverse() { return BitReverse::values; }
+};
+
+#endif